@@ -0,0 +1,138 @@
+// compress.h — brzi LZ kodek (LZ4 block format) + slanje/prijem int nizova sa opcionom kompresijom
+// Header-only: uključuje ga master.c i worker.c, build linija ostaje ista.
+//
+// Kompresovana poruka ide sa tagom (TAG | TAG_LZ) kao MPI_BYTE: [int raw_bytes][LZ blok].
+// Male poruke (< min_bytes) i one koje se ne smanje idu bez kompresije, sa originalnim tagom.
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { TAG_LZ = 0x100 };   // bit u tagu: payload je LZ kompresovan
+enum { CAP_LZ = 0x2 };     // bit u admission pregovoru: strana podržava TAG_LZ
+
+#define LZ_MINMATCH     4
+#define LZ_LASTLITERALS 5    // poslednjih 5 bajtova su uvek literali
+#define LZ_MFLIMIT      12   // poslednji match počinje najkasnije 12 bajtova pre kraja
+#define LZ_HASH_LOG     12
+
+static inline uint32_t lz_read32(const uint8_t* p){ uint32_t v; memcpy(&v,p,4); return v; }
+static inline uint32_t lz_hash(uint32_t v){ return (v*2654435761u) >> (32-LZ_HASH_LOG); }
+static inline int lz_bound(int n){ return n + n/255 + 16; }
+
+static inline uint8_t* lz_put_len(uint8_t* op, int len){
+  while (len>=255){ *op++=255; len-=255; }
+  *op++=(uint8_t)len; return op;
+}
+
+// greedy kompresor; vraća broj bajtova u dst ili 0 ako ne staje u cap
+static inline int lz_compress(const void* src_, int n, void* dst_, int cap){
+  const uint8_t* src=(const uint8_t*)src_; uint8_t* dst=(uint8_t*)dst_;
+  const uint8_t *ip=src, *anchor=src, *iend=src+n;
+  uint8_t *op=dst, *oend=dst+cap;
+  int table[1<<LZ_HASH_LOG]; memset(table,0,sizeof table);   // pozicija+1, 0 = prazno
+
+  if (n > LZ_MFLIMIT){
+    const uint8_t *mflimit=iend-LZ_MFLIMIT, *matchlimit=iend-LZ_LASTLITERALS;
+    while (ip < mflimit){
+      uint32_t seq=lz_read32(ip), h=lz_hash(seq);
+      const uint8_t* ref = table[h] ? src+table[h]-1 : NULL;
+      table[h]=(int)(ip-src)+1;
+      if (!ref || ip-ref>65535 || lz_read32(ref)!=seq){ ip++; continue; }
+
+      const uint8_t *mp=ip+LZ_MINMATCH, *rp=ref+LZ_MINMATCH;
+      while (mp<matchlimit && *mp==*rp){ mp++; rp++; }
+      int lit=(int)(ip-anchor), ml=(int)(mp-ip)-LZ_MINMATCH;
+      if (op + 1 + lit/255+1 + lit + 2 + ml/255+1 > oend) return 0;
+
+      uint8_t* token=op++;
+      *token=(uint8_t)(((lit>=15?15:lit)<<4) | (ml>=15?15:ml));
+      if (lit>=15) op=lz_put_len(op,lit-15);
+      memcpy(op,anchor,lit); op+=lit;
+      int off=(int)(ip-ref); *op++=(uint8_t)(off&255); *op++=(uint8_t)(off>>8);
+      if (ml>=15) op=lz_put_len(op,ml-15);
+      ip=anchor=mp;
+    }
+  }
+
+  int lit=(int)(iend-anchor);
+  if (op + 1 + lit/255+1 + lit > oend) return 0;
+  *op++=(uint8_t)((lit>=15?15:lit)<<4);
+  if (lit>=15) op=lz_put_len(op,lit-15);
+  memcpy(op,anchor,lit); op+=lit;
+  return (int)(op-dst);
+}
+
+// dekompresor sa proverom granica; vraća broj bajtova u dst ili -1 za neispravan ulaz
+static inline int lz_decompress(const void* src_, int n, void* dst_, int cap){
+  const uint8_t *ip=(const uint8_t*)src_, *iend=ip+n;
+  uint8_t *dst=(uint8_t*)dst_, *op=dst, *oend=dst+cap;
+  while (ip<iend){
+    unsigned t=*ip++, b;
+    size_t lit=t>>4;
+    if (lit==15) do { if (ip>=iend) return -1; b=*ip++; lit+=b; } while (b==255);
+    if (lit>(size_t)(iend-ip) || lit>(size_t)(oend-op)) return -1;
+    memcpy(op,ip,lit); op+=lit; ip+=lit;
+    if (ip>=iend) break;                       // poslednja sekvenca nema match
+
+    if (iend-ip<2) return -1;
+    size_t off=(size_t)ip[0] | ((size_t)ip[1]<<8); ip+=2;
+    if (off==0 || off>(size_t)(op-dst)) return -1;
+    size_t ml=t&15;
+    if (ml==15) do { if (ip>=iend) return -1; b=*ip++; ml+=b; } while (b==255);
+    ml+=LZ_MINMATCH;
+    if (ml>(size_t)(oend-op)) return -1;
+    const uint8_t* m=op-off;
+    for (size_t i=0;i<ml;++i) op[i]=m[i];      // preklapanje je dozvoljeno (off < ml)
+    op+=ml;
+  }
+  return (int)(op-dst);
+}
+
+static uint8_t* g_lz_buf = NULL;
+static int g_lz_cap = 0;
+static inline uint8_t* lz_scratch(int need){
+  if (need>g_lz_cap){ g_lz_cap=need; g_lz_buf=(uint8_t*)realloc(g_lz_buf,g_lz_cap); }
+  return g_lz_buf;
+}
+
+// pošalji n int-ova; kompresuje samo ako je use_lz, poruka >= min_bytes i kompresija se isplati
+static inline int lz_send_ints(const int* buf, int n, int dest, int tag, MPI_Comm C, int use_lz, int min_bytes){
+  int raw=n*(int)sizeof(int);
+  if (use_lz && raw>=min_bytes && raw>0){
+    uint8_t* out=lz_scratch((int)sizeof(int)+lz_bound(raw));
+    int clen=lz_compress(buf, raw, out+sizeof(int), raw-1);
+    if (clen>0 && clen+(int)sizeof(int)<raw){
+      memcpy(out,&raw,sizeof(int));
+      return MPI_Send(out,(int)sizeof(int)+clen,MPI_BYTE,dest,tag|TAG_LZ,C);
+    }
+  }
+  return MPI_Send((void*)buf,n,MPI_INT,dest,tag,C);
+}
+
+// posle MPI_Mprobe: primi uparenu poruku (sa ili bez TAG_LZ) u *buf (raste po potrebi); vraća broj int-ova ili -1
+static inline int lz_recv_ints(MPI_Message* msg, const MPI_Status* st, int** buf, int* cap){
+  if (!(st->MPI_TAG & TAG_LZ)){
+    int n=0; MPI_Get_count(st,MPI_INT,&n);
+    if (n>*cap){ *cap=n; *buf=(int*)realloc(*buf,sizeof(int)*n); }
+    MPI_Mrecv(*buf,n,MPI_INT,msg,MPI_STATUS_IGNORE);
+    return n;
+  }
+  int nb=0; MPI_Get_count(st,MPI_BYTE,&nb);
+  uint8_t* in=lz_scratch(nb);
+  MPI_Mrecv(in,nb,MPI_BYTE,msg,MPI_STATUS_IGNORE);
+  int raw=0; if (nb>=(int)sizeof(int)) memcpy(&raw,in,sizeof(int));
+  if (raw<=0 || raw%(int)sizeof(int)){ fprintf(stderr,"lz: neispravan header (%d B)\n", raw); return -1; }
+  int n=raw/(int)sizeof(int);
+  if (n>*cap){ *cap=n; *buf=(int*)realloc(*buf,sizeof(int)*n); }
+  if (lz_decompress(in+sizeof(int), nb-(int)sizeof(int), *buf, raw)!=raw){
+    fprintf(stderr,"lz: dekompresija nije uspela (tag=%d)\n", st->MPI_TAG); return -1;
+  }
+  return n;
+}
+
+#endif
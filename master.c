@@ -1,126 +1,874 @@
-// master.c — primi tačno TARGET_WORKERS workera pa startuj posao
-// Build: mpicc -O2 -std=gnu11 -o master master.c
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-enum {
-  TAG_HELLO=1, TAG_MERGE_CMD=2, TAG_READY=3,
-  TAG_TASK=10, TAG_RESULT=11, TAG_IDLE=13
-};
-
-static void perr(const char* where, int rc){
-  if (rc==MPI_SUCCESS) return;
-  char es[256]; int n=0; MPI_Error_string(rc, es, &n);
-  fprintf(stderr,"[MASTER] %s rc=%d (%s)\n", where, rc, es); fflush(stderr);
-}
-
-static int getenv_int(const char* k, int defv){
-  const char* s=getenv(k); if(!s||!*s) return defv; int v=atoi(s); return v>0?v:defv;
-}
-
-// broadcast: (more, len, port) — da svi znaju da li sledi novi prijem i koji je PORT
-static void bcast_more_and_port(MPI_Comm C, int more, const char* port){
-  int len = (int)strlen(port) + 1;                 // uključujući \0
-  MPI_Bcast(&more, 1, MPI_INT, 0, C);
-  MPI_Bcast(&len,  1, MPI_INT, 0, C);
-  MPI_Bcast((void*)port, len, MPI_CHAR, 0, C);
-}
-
-int main(int argc,char**argv){
-  MPI_Init(&argc,&argv);
-
-  const int TARGET = getenv_int("TARGET_WORKERS", 1);
-
-  // 1) Otvori port i upiši ga u port.txt (da worker skripte imaju pouzdan izvor)
-  char PORT[MPI_MAX_PORT_NAME];
-  int rc = MPI_Open_port(MPI_INFO_NULL, PORT); perr("Open_port", rc);
-  if (rc!=MPI_SUCCESS) MPI_Abort(MPI_COMM_WORLD,1);
-
-  // napiši i na stdout i u port.txt
-  printf("%s\n", PORT); fflush(stdout);
-  { FILE* f=fopen("port.txt","w"); if(f){ fprintf(f,"%s\n",PORT); fclose(f);} else { perror("[MASTER] fopen(port.txt)"); } }
-
-  // 2) CLUSTER = duplikat self (da smemo da ga free-ujemo)
-  MPI_Comm CLUSTER; rc = MPI_Comm_dup(MPI_COMM_SELF, &CLUSTER); perr("Comm_dup(self)", rc);
-
-  int added = 0;
-
-  // === PRVI worker: accept na SELF (samo master u lokalnoj grupi) ===
-  {
-    MPI_Comm inter;
-    rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, MPI_COMM_SELF, &inter); perr("Comm_accept#1", rc);
-
-    int hello=0; rc = MPI_Recv(&hello,1,MPI_INT,0,TAG_HELLO,inter,MPI_STATUS_IGNORE); perr("Recv(HELLO#1)", rc);
-    int cmd=1;   rc = MPI_Send(&cmd,1,MPI_INT,0,TAG_MERGE_CMD,inter); perr("Send(MERGE_CMD#1)", rc);
-    int ready=0; rc = MPI_Recv(&ready,1,MPI_INT,0,TAG_READY,inter,MPI_STATUS_IGNORE); perr("Recv(READY#1)", rc);
-
-    rc = MPI_Barrier(inter); perr("Barrier(inter#1)", rc);
-
-    MPI_Comm NEWC; rc = MPI_Intercomm_merge(inter, 0, &NEWC); perr("Intercomm_merge#1", rc);
-    MPI_Comm_disconnect(&inter);
-    MPI_Comm_free(&CLUSTER); CLUSTER = NEWC;
-
-    int s; MPI_Comm_size(CLUSTER,&s);
-    printf("[MASTER] merged one -> size=%d (workers=%d)\n", s, s-1); fflush(stdout);
-    added = 1;
-
-    // novi član mora da dobije PORT za buduće kolektivne prijeme
-    bcast_more_and_port(CLUSTER, /*more=*/ (added<TARGET?1:0), PORT);
-  }
-
-  // === Dalji workeri: KOLEKTIVNI accept preko CLUSTER-a ===
-  while (added < TARGET){
-    // svi u CLUSTER-u (master + već pristigli) znaju da sledi još jedan prijem i PORT
-    // (napomena: posle PRVOG merge-a već smo poslali more/port, ali ne škodi idempotentno)
-    // bcast_more_and_port(CLUSTER, 1, PORT);  // već odrađeno gore posle 1. merge-a
-
-    MPI_Comm inter2;
-    rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, CLUSTER, &inter2); perr("Comm_accept#next", rc);
-
-    // samo master komunicira P2P sa novim (remote rank 0)
-    int cmd=1;   rc = MPI_Send(&cmd,1,MPI_INT,0,TAG_MERGE_CMD,inter2); perr("Send(MERGE_CMD#next)", rc);
-    int ready=0; rc = MPI_Recv(&ready,1,MPI_INT,0,TAG_READY,inter2,MPI_STATUS_IGNORE); perr("Recv(READY#next)", rc);
-
-    rc = MPI_Barrier(inter2); perr("Barrier(inter#next)", rc);
-
-    MPI_Comm CL_NEW; rc = MPI_Intercomm_merge(inter2, 0, &CL_NEW); perr("Intercomm_merge#next", rc);
-    MPI_Comm_disconnect(&inter2);
-
-    MPI_Comm_free(&CLUSTER); CLUSTER = CL_NEW;
-    int s; MPI_Comm_size(CLUSTER,&s);
-    printf("[MASTER] merged one -> size=%d (workers=%d)\n", s, s-1); fflush(stdout);
-    added++;
-
-    // NOVO: posle SVAKOG merge-a — svi dobijaju PORT za eventualno sledeći krug
-    bcast_more_and_port(CLUSTER, /*more=*/ (added<TARGET?1:0), PORT);
-  }
-
-  // === TASK-FARM DEMO ===
-  int tasks[] = {2,3,4,5,6,7,8,9,10};
-  int NT = (int)(sizeof(tasks)/sizeof(tasks[0]));
-  int next = 0;
-
-  int size, rank; MPI_Comm_size(CLUSTER,&size); MPI_Comm_rank(CLUSTER,&rank);
-  if (size > 1){
-    // inicijalno: svima po 1 posao ili IDLE
-    for (int w=1; w<size; ++w){
-      if (next<NT) MPI_Send(&tasks[next++],1,MPI_INT,w,TAG_TASK,CLUSTER);
-      else         MPI_Send(NULL,0,MPI_INT,w,TAG_IDLE,CLUSTER);
-    }
-    // glavna petlja raspodele
-    for(;;){
-      int pair[2]; MPI_Status st;
-      MPI_Recv(pair,2,MPI_INT,MPI_ANY_SOURCE,TAG_RESULT,CLUSTER,&st);
-      printf("[MASTER] result: %d -> %d (from %d)\n", pair[0], pair[1], st.MPI_SOURCE); fflush(stdout);
-      if (next<NT) MPI_Send(&tasks[next++],1,MPI_INT,st.MPI_SOURCE,TAG_TASK,CLUSTER);
-      else         MPI_Send(NULL,0,MPI_INT,st.MPI_SOURCE,TAG_IDLE,CLUSTER);
-    }
-  }
-
-  MPI_Close_port(PORT);
-  MPI_Comm_free(&CLUSTER);
-  MPI_Finalize();
-  return 0;
-}
+// master.c — primi tačno TARGET_WORKERS workera pa startuj posao
+//            (ili, uz SPAWN_WORKERS / SPAWN_HOSTFILE, sam spawn-uje workere)
+// Build: mpicc -O2 -std=gnu11 -pthread -o master master.c
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <dirent.h>
+#include "compress.h"
+#include "metrics.h"
+
+enum {
+  TAG_HELLO=1, TAG_MERGE_CMD=2, TAG_READY=3,
+  TAG_TASK=10, TAG_RESULT=11, TAG_IDLE=13,
+  TAG_TASK_STREAM=14, TAG_TASK_PIECE=15,  // veliki chunk: zaglavlje {n, piece} pa delovi
+  TAG_SHRINK=16,                          // scale-in: {keep} pa Comm_split celog CLUSTER-a
+  TAG_TASK_AT=17, TAG_OUTPUT=18, TAG_WRITTEN=19,  // RESULTS_FILE: [start, x...], putanja, potvrda {n}
+  TAG_INPUT=20, TAG_TASK_RANGE=21                 // INPUT_FILE: putanja, {offset, len} u bajtovima
+};
+enum { CAP_STREAM = 0x4 };   // worker prima TAG_TASK_STREAM (dvostruki baferi, preklapanje sa računanjem)
+
+static void perr(const char* where, int rc){
+  if (rc==MPI_SUCCESS) return;
+  char es[256]; int n=0; MPI_Error_string(rc, es, &n);
+  fprintf(stderr,"[MASTER] %s rc=%d (%s)\n", where, rc, es); fflush(stderr);
+}
+
+static int getenv_int(const char* k, int defv){
+  const char* s=getenv(k); if(!s||!*s) return defv; int v=atoi(s); return v>0?v:defv;
+}
+
+// pregovor pri prijemu: master nudi {1, caps, COMPRESS_MIN_BYTES}, worker vraća {1, prihvaćeni caps}
+static int g_offer = 0, g_lz_min = 4096;
+static int g_stream_min = 1<<20, g_stream_piece = 256<<10;   // STREAM_MIN_BYTES, STREAM_PIECE_BYTES
+// RESULTS_FILE: workeri pišu int32 y taska i na bajt i*4 (MPI_File_write_at), master prima samo {n}
+// INPUT_FILE: ulaz taska i je int32 na bajtu i*4; master šalje samo opseg, workeri čitaju (MPI_File_read_at)
+static const char *g_out_path = NULL, *g_in_path = NULL;
+static MPI_File g_out = MPI_FILE_NULL, g_in = MPI_FILE_NULL;
+static int* g_caps = NULL; static int g_ncaps = 0;   // prihvaćeni caps po rangu u CLUSTER-u
+static void set_caps(int rank, int caps){
+  if (rank>=g_ncaps){ int n=rank+16; g_caps=realloc(g_caps,sizeof(int)*n); memset(g_caps+g_ncaps,0,sizeof(int)*(n-g_ncaps)); g_ncaps=n; }
+  g_caps[rank]=caps;
+}
+static int get_caps(int rank){ return rank<g_ncaps ? g_caps[rank] : 0; }
+
+// neuspelo otvaranje (i ponovno, posle scale-in-a) prekida ceo posao, isto kao u workeru
+static MPI_File file_open(MPI_Comm C, const char* path, int amode){
+  MPI_File fh; int rc = MPI_File_open(C, (char*)path, amode, MPI_INFO_NULL, &fh);
+  if (rc!=MPI_SUCCESS){ fprintf(stderr,"[MASTER] %s: ", path); perr("File_open", rc); MPI_Abort(MPI_COMM_WORLD,1); }
+  return fh;
+}
+#define OUT_MODE (MPI_MODE_WRONLY|MPI_MODE_CREATE)
+#define IN_MODE  MPI_MODE_RDONLY
+
+// pre prvog dispatch-a (svi workeri čekaju u Mprobe): putanja ide svakom workeru (tag kaže ulaz ili
+// izlaz), pa ceo CLUSTER zajedno otvara fajl; bez fajla workeri ne bi imali odakle da čitaju / gde da pišu
+static MPI_File file_start(MPI_Comm C, int tag, const char* path, int amode){
+  int size; MPI_Comm_size(C,&size);
+  for (int w=1; w<size; ++w) MPI_Send((void*)path,(int)strlen(path)+1,MPI_CHAR,w,tag,C);
+  return file_open(C, path, amode);
+}
+
+// SPAWN_HOSTFILE: linije "host [slots=N]", '#' je komentar; vraća broj hostova
+#define MAX_SPAWN_HOSTS 256
+static int read_hostfile(const char* path, char hosts[][256], int* slots){
+  FILE* f=fopen(path,"r"); if(!f){ perror("[MASTER] fopen(SPAWN_HOSTFILE)"); return 0; }
+  int n=0; char line[512];
+  while (n<MAX_SPAWN_HOSTS && fgets(line,sizeof line,f)){
+    char* h=strtok(line," \t\r\n"); if(!h || h[0]=='#') continue;
+    snprintf(hosts[n],256,"%s",h); slots[n]=1;
+    for(char* t=strtok(NULL," \t\r\n"); t; t=strtok(NULL," \t\r\n")){
+      if (t[0]=='#') break;
+      if (!strncmp(t,"slots=",6) && atoi(t+6)>0) slots[n]=atoi(t+6);
+    }
+    n++;
+  }
+  fclose(f); return n;
+}
+
+// static alokacija: master sam pokreće workere (jedan spawn, jedan merge, bez porta)
+static MPI_Comm spawn_cluster(int count, const char* hostfile){
+  const char* bin = getenv("WORKER_BIN"); if(!bin||!*bin) bin="./worker";
+  static char hosts[MAX_SPAWN_HOSTS][256]; static int slots[MAX_SPAWN_HOSTS];
+  int nh = hostfile ? read_hostfile(hostfile, hosts, slots) : 0;
+  int ncmd = nh>0 ? nh : 1;
+  if (nh==0 && count<=0){ fprintf(stderr,"[MASTER] spawn: prazan hostfile i SPAWN_WORKERS=0\n"); MPI_Abort(MPI_COMM_WORLD,1); }
+
+  char** cmds = malloc(sizeof(char*)*ncmd);
+  int* maxprocs = malloc(sizeof(int)*ncmd);
+  MPI_Info* infos = malloc(sizeof(MPI_Info)*ncmd);
+  for (int i=0;i<ncmd;++i){
+    cmds[i]=(char*)bin;
+    if (nh>0){ maxprocs[i]=slots[i]; MPI_Info_create(&infos[i]); MPI_Info_set(infos[i],"host",hosts[i]); }
+    else     { maxprocs[i]=count; infos[i]=MPI_INFO_NULL; }
+  }
+
+  int total=0; for (int i=0;i<ncmd;++i) total+=maxprocs[i];
+  int* errs = malloc(sizeof(int)*(total>0?total:1));
+  MPI_Comm inter;
+  int rc = MPI_Comm_spawn_multiple(ncmd, cmds, MPI_ARGVS_NULL, maxprocs, infos, 0, MPI_COMM_SELF, &inter, errs);
+  perr("Comm_spawn_multiple", rc);
+  if (rc!=MPI_SUCCESS) MPI_Abort(MPI_COMM_WORLD,1);
+  for (int i=0;i<total;++i) perr("spawn(child)", errs[i]);
+
+  MPI_Comm C; rc = MPI_Intercomm_merge(inter, 0, &C); perr("Intercomm_merge(spawn)", rc);
+  MPI_Comm_disconnect(&inter);
+
+  // pregovor za sve odjednom: ponuda Bcast-om, odgovori Gather-om
+  int offer[2]={g_offer, g_lz_min}, mine=0, s; MPI_Comm_size(C,&s);
+  int* caps = malloc(sizeof(int)*s);
+  MPI_Bcast(offer,2,MPI_INT,0,C);
+  MPI_Gather(&mine,1,MPI_INT,caps,1,MPI_INT,0,C);
+  for (int r=1;r<s;++r) set_caps(r, caps[r]);
+  free(caps);
+
+  for (int i=0;i<ncmd;++i) if (infos[i]!=MPI_INFO_NULL) MPI_Info_free(&infos[i]);
+  free(errs); free(infos); free(maxprocs); free(cmds);
+  return C;
+}
+
+// broadcast: (more, len, port) — da svi znaju da li sledi novi prijem i koji je PORT
+static void bcast_more_and_port(MPI_Comm C, int more, const char* port){
+  int len = (int)strlen(port) + 1;                 // uključujući \0
+  MPI_Bcast(&more, 1, MPI_INT, 0, C);
+  MPI_Bcast(&len,  1, MPI_INT, 0, C);
+  MPI_Bcast((void*)port, len, MPI_CHAR, 0, C);
+}
+
+// port režim: ompi-server + port.txt, prvi worker na SELF, ostali kolektivnim accept-om
+static MPI_Comm port_admission(char* PORT, int TARGET){
+  int rc;
+  MPI_Comm CLUSTER;
+
+  // 1) Otvori port i upiši ga u port.txt (da worker skripte imaju pouzdan izvor)
+  rc = MPI_Open_port(MPI_INFO_NULL, PORT); perr("Open_port", rc);
+  if (rc!=MPI_SUCCESS) MPI_Abort(MPI_COMM_WORLD,1);
+
+  // napiši i na stdout i u port.txt
+  printf("%s\n", PORT); fflush(stdout);
+  { FILE* f=fopen("port.txt","w"); if(f){ fprintf(f,"%s\n",PORT); fclose(f);} else { perror("[MASTER] fopen(port.txt)"); } }
+
+  // 2) CLUSTER = duplikat self (da smemo da ga free-ujemo)
+  rc = MPI_Comm_dup(MPI_COMM_SELF, &CLUSTER); perr("Comm_dup(self)", rc);
+
+  int added = 0;
+
+  // === PRVI worker: accept na SELF (samo master u lokalnoj grupi) ===
+  {
+    MPI_Comm inter;
+    rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, MPI_COMM_SELF, &inter); perr("Comm_accept#1", rc);
+    double t_round=MPI_Wtime();   // runda se meri od accept-a (čekanje na workera nije trošak runde)
+
+    int hello=0; rc = MPI_Recv(&hello,1,MPI_INT,0,TAG_HELLO,inter,MPI_STATUS_IGNORE); perr("Recv(HELLO#1)", rc);
+    int cmd[3]={1,g_offer,g_lz_min}; rc = MPI_Send(cmd,3,MPI_INT,0,TAG_MERGE_CMD,inter); perr("Send(MERGE_CMD#1)", rc);
+    int ready[2]={0,0}; rc = MPI_Recv(ready,2,MPI_INT,0,TAG_READY,inter,MPI_STATUS_IGNORE); perr("Recv(READY#1)", rc);
+
+    rc = MPI_Barrier(inter); perr("Barrier(inter#1)", rc);
+
+    MPI_Comm NEWC; rc = MPI_Intercomm_merge(inter, 0, &NEWC); perr("Intercomm_merge#1", rc);
+    MPI_Comm_disconnect(&inter);
+    MPI_Comm_free(&CLUSTER); CLUSTER = NEWC;
+
+    int s; MPI_Comm_size(CLUSTER,&s);
+    set_caps(s-1, ready[1]);
+    printf("[MASTER] merged one -> size=%d (workers=%d)\n", s, s-1); fflush(stdout);
+    added = 1;
+
+    // novi član mora da dobije PORT za buduće kolektivne prijeme
+    bcast_more_and_port(CLUSTER, /*more=*/ (added<TARGET?1:0), PORT);
+    m_admission(MPI_Wtime()-t_round, 1);
+  }
+
+  // === Dalji workeri: KOLEKTIVNI accept preko CLUSTER-a ===
+  while (added < TARGET){
+    // svi u CLUSTER-u (master + već pristigli) znaju da sledi još jedan prijem i PORT
+    // (napomena: posle PRVOG merge-a već smo poslali more/port, ali ne škodi idempotentno)
+    // bcast_more_and_port(CLUSTER, 1, PORT);  // već odrađeno gore posle 1. merge-a
+
+    MPI_Comm inter2;
+    rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, CLUSTER, &inter2); perr("Comm_accept#next", rc);
+    double t_round=MPI_Wtime();
+
+    // samo master komunicira P2P sa novim (remote rank 0)
+    int cmd[3]={1,g_offer,g_lz_min}; rc = MPI_Send(cmd,3,MPI_INT,0,TAG_MERGE_CMD,inter2); perr("Send(MERGE_CMD#next)", rc);
+    int ready[2]={0,0}; rc = MPI_Recv(ready,2,MPI_INT,0,TAG_READY,inter2,MPI_STATUS_IGNORE); perr("Recv(READY#next)", rc);
+
+    rc = MPI_Barrier(inter2); perr("Barrier(inter#next)", rc);
+
+    MPI_Comm CL_NEW; rc = MPI_Intercomm_merge(inter2, 0, &CL_NEW); perr("Intercomm_merge#next", rc);
+    MPI_Comm_disconnect(&inter2);
+
+    MPI_Comm_free(&CLUSTER); CLUSTER = CL_NEW;
+    int s; MPI_Comm_size(CLUSTER,&s);
+    set_caps(s-1, ready[1]);
+    printf("[MASTER] merged one -> size=%d (workers=%d)\n", s, s-1); fflush(stdout);
+    added++;
+
+    // NOVO: posle SVAKOG merge-a — svi dobijaju PORT za eventualno sledeći krug
+    bcast_more_and_port(CLUSTER, /*more=*/ (added<TARGET?1:0), PORT);
+    m_admission(MPI_Wtime()-t_round, 1);
+  }
+
+  return CLUSTER;
+}
+
+// === ORDERED=1: rezultati izlaze po redosledu taskova ===
+// Prozor od REORDER_WINDOW taskova počev od emit (najstariji task bez rezultata); dispatch ne šalje
+// task >= emit+W, pa je bafer ograničen i nema sortiranja na kraju posla.
+typedef struct { int on, W, emit; int *y, *from; unsigned char* have; } Reorder;
+
+static void reorder_init(Reorder* R){
+  // RESULTS_FILE je već po redu taskova, pa tada prozor nije potreban
+  R->on = getenv_int("ORDERED", 0) && !g_out_path; R->W = getenv_int("REORDER_WINDOW", 4096); R->emit = 0;
+  R->y = R->on ? malloc(sizeof(int)*R->W) : NULL; R->from = R->on ? malloc(sizeof(int)*R->W) : NULL;
+  R->have = R->on ? calloc(R->W,1) : NULL;
+}
+static void reorder_free(Reorder* R){ free(R->y); free(R->from); free(R->have); }
+static void reorder_put(Reorder* R, int task, int y, int from){
+  int k = task % R->W; R->y[k]=y; R->from[k]=from; R->have[k]=1;
+}
+
+// === POSLOVI: svaki ima svoj red taskova, ORDERED prozor i odredište rezultata ===
+// Bez SPOOL_DIR postoji jedan posao (NUM_TASKS taskova, rezultati na stdout), kao i do sada.
+// Sa SPOOL_DIR master ostaje živ posle posla i preuzima <ime>.job fajlove; rezultati idu u <ime>.out.
+typedef struct {
+  char name[256];
+  int* tasks; int NT, next, limit, ndone;   // ne šalje se task >= limit (ORDERED backpressure)
+  unsigned char* done;                      // [task] = rezultat već primljen (prvi pobeđuje)
+  double weight, vtime;                     // fair share: vtime raste za c/weight po poslatom chunk-u
+  int refs, finished;                       // refs = rangova kojima je chunk ovog posla u letu
+  Reorder R;
+  FILE* out; char dir[1024];                // out==NULL → stdout (posao bez spool-a)
+  double t0;
+} Job;
+
+static Job* job_new(const char* name, int* tasks, int NT, double weight){
+  Job* J=calloc(1,sizeof(Job));
+  snprintf(J->name,sizeof J->name,"%s",name);
+  J->tasks=tasks; J->NT=NT; J->limit=NT; J->weight = weight>0 ? weight : 1;
+  J->done=calloc(NT>0?NT:1,1);
+  reorder_init(&J->R); if (J->R.on) J->limit=J->R.W;
+  J->t0=MPI_Wtime();
+  return J;
+}
+
+static void job_free(Job* J){
+  reorder_free(&J->R); if (J->out) fclose(J->out);
+  free(J->done); free(J->tasks); free(J);
+}
+
+// koliko taskova sme da ode sada: do kraja reda, ali ne preko limit-a
+static int job_room(const Job* J){ return (J->limit < J->NT ? J->limit : J->NT) - J->next; }
+
+static void job_emit(Job* J, int i, int y, int from){
+  if (!J->tasks) printf("[MASTER] result: #%d -> %d (from %d)\n", i, y, from);   // INPUT_FILE: master ne zna ulaz
+  else if (J->out) fprintf(J->out,"%d %d\n", J->tasks[i], y);
+  else printf("[MASTER] result: %d -> %d (from %d)\n", J->tasks[i], y, from);
+}
+
+// ispiši sve što je spremno po redu; vraća broj ispisanih
+static int reorder_flush(Reorder* R, Job* J){
+  int n=0;
+  for (int k=R->emit%R->W; R->have[k]; k=R->emit%R->W){
+    job_emit(J, R->emit, R->y[k], R->from[k]);
+    R->have[k]=0; R->emit++; n++;
+  }
+  return n;
+}
+
+// <ime>.run: ulazi taskova (celi brojevi) razdvojeni belinom, "weight=W" bilo gde, '#' do kraja reda je komentar
+static Job* job_load(const char* dir, const char* name){
+  char path[1400]; snprintf(path,sizeof path,"%s/%s.run",dir,name);
+  FILE* f=fopen(path,"r"); if(!f){ perror("[MASTER] fopen(.run)"); return NULL; }
+  int cap=1024, n=0; int* t=malloc(sizeof(int)*cap); double weight=1; char tok[256];
+  while (fscanf(f,"%255s",tok)==1){
+    if (tok[0]=='#'){ int ch; while ((ch=fgetc(f))!=EOF && ch!='\n'){} continue; }
+    if (!strncmp(tok,"weight=",7)){ weight=atof(tok+7); continue; }
+    char* end; long v=strtol(tok,&end,10);
+    if (*end){ fprintf(stderr,"[MASTER] %s: preskačem '%s'\n", path, tok); continue; }
+    if (n==cap){ cap*=2; t=realloc(t,sizeof(int)*cap); }
+    t[n++]=(int)v;
+  }
+  fclose(f);
+  Job* J=job_new(name,t,n,weight);
+  snprintf(J->dir,sizeof J->dir,"%s",dir);
+  snprintf(path,sizeof path,"%s/%s.out.tmp",dir,name);
+  if (!(J->out=fopen(path,"w"))){ perror("[MASTER] fopen(.out.tmp)"); job_free(J); return NULL; }
+  return J;
+}
+
+// svi taskovi imaju rezultat: <ime>.out.tmp → <ime>.out i <ime>.run → <ime>.done (čitač nikad ne vidi pola fajla)
+static void job_finish(Job* J){
+  J->finished=1;
+  if (g_out_path){ printf("[MASTER] results: %d tasks written to %s in %.3fs\n", J->NT, g_out_path, MPI_Wtime()-J->t0); fflush(stdout); }
+  if (!J->out) return;
+  fclose(J->out); J->out=NULL;
+  char a[1400], b[1400];
+  snprintf(a,sizeof a,"%s/%s.out.tmp",J->dir,J->name); snprintf(b,sizeof b,"%s/%s.out",J->dir,J->name); rename(a,b);
+  snprintf(a,sizeof a,"%s/%s.run",J->dir,J->name);     snprintf(b,sizeof b,"%s/%s.done",J->dir,J->name); rename(a,b);
+  printf("[MASTER] job %s done: %d tasks in %.3fs\n", J->name, J->NT, MPI_Wtime()-J->t0); fflush(stdout);
+}
+
+// === SELF-SCHEDULING: koliko taskova ide u jedan TAG_TASK ===
+// SCHED=single (1 task/poruka, default) | guided | factoring | adaptive
+// guided:    chunk = ceil(R/P)                       — krupno na početku, sitno na kraju
+// factoring: serija od P chunk-ova po ceil(R/(2P))    — R se meri na početku serije
+// adaptive:  chunk = SCHED_TARGET_MS / (EWMA vremena po tasku za tog workera), ograničen guided-om
+typedef enum { SCHED_SINGLE, SCHED_GUIDED, SCHED_FACTORING, SCHED_ADAPTIVE } SchedKind;
+
+typedef struct {
+  SchedKind kind;
+  int P, min_chunk, max_chunk;
+  int fact_left, fact_chunk;      // factoring: preostalo u seriji, veličina chunk-a serije
+  double target_s;                // adaptive: ciljano trajanje jednog chunk-a
+  double* t_task;                 // adaptive: EWMA sekundi po tasku, po rangu (0 = još nije mereno)
+} Sched;
+
+static const char* sched_name(SchedKind k){
+  switch(k){ case SCHED_GUIDED: return "guided"; case SCHED_FACTORING: return "factoring";
+             case SCHED_ADAPTIVE: return "adaptive"; default: return "single"; }
+}
+
+static void sched_init(Sched* S, int size){
+  const char* k=getenv("SCHED"); S->kind=SCHED_SINGLE;
+  if (k && !strcmp(k,"guided"))    S->kind=SCHED_GUIDED;
+  if (k && !strcmp(k,"factoring")) S->kind=SCHED_FACTORING;
+  if (k && !strcmp(k,"adaptive"))  S->kind=SCHED_ADAPTIVE;
+  S->P = size-1;
+  S->min_chunk = getenv_int("SCHED_MIN_CHUNK", 1);
+  S->max_chunk = getenv_int("SCHED_MAX_CHUNK", 1024);
+  if (S->max_chunk < S->min_chunk) S->max_chunk = S->min_chunk;
+  S->fact_left = 0; S->fact_chunk = 0;
+  S->target_s = getenv_int("SCHED_TARGET_MS", 50) / 1000.0;
+  S->t_task = calloc(size, sizeof(double));
+}
+
+static int sched_chunk(Sched* S, int w, int remaining){
+  if (remaining<=0) return 0;
+  int c = 1, guided = (remaining + S->P - 1) / S->P;
+  switch (S->kind){
+    case SCHED_SINGLE:    return 1;
+    case SCHED_GUIDED:    c = guided; break;
+    case SCHED_FACTORING:
+      if (S->fact_left==0){ S->fact_chunk = (remaining + 2*S->P - 1) / (2*S->P); S->fact_left = S->P; }
+      S->fact_left--; c = S->fact_chunk; break;
+    case SCHED_ADAPTIVE:
+      c = S->t_task[w] > 0 ? (int)(S->target_s / S->t_task[w]) : S->min_chunk;  // prvi chunk = proba
+      if (c > guided) c = guided;
+      break;
+  }
+  if (c < S->min_chunk) c = S->min_chunk;
+  if (c > S->max_chunk) c = S->max_chunk;
+  return c < remaining ? c : remaining;
+}
+
+// posle rezultata: izmereno vreme chunk-a (uključuje i put kroz mrežu)
+static void sched_observe(Sched* S, int w, int count, double elapsed){
+  if (count<=0 || elapsed<=0) return;
+  double per = elapsed / count;
+  S->t_task[w] = S->t_task[w] > 0 ? 0.7*S->t_task[w] + 0.3*per : per;
+}
+
+// najduži san glavne petlje kad uz SPOOL_DIR / RELEASE_FILE nema ničeg u letu (oba se ionako
+// proveravaju na SPOOL_POLL_MS / 100 ms), pa idle master ne vrti Improbe
+#define IDLE_NAP_MAX_US 20000
+
+// koliko poslednjih rezultata ulazi u medijanu za spekulaciju (prati promenu brzine, memorija ograničena)
+#define SPEC_WINDOW 256
+
+// stanje farme po rangu; poruke fiksnog oblika (1 task, IDLE) idu kroz persistentne zahteve
+typedef struct {
+  MPI_Comm C; int size;
+  Job** jobs; int njobs, jobs_cap;          // aktivni poslovi, redom prijema
+  Job** jw;                                 // [rang] = posao čiji chunk je u letu (NULL = nijedan)
+  double vclock;                            // fair share: vtime poslednjeg izabranog posla
+  const char* spool; int spool_ms; double spool_t;   // SPOOL_DIR, SPOOL_POLL_MS, poslednji pregled
+  int *s_sent, *n_sent; double* t_sent;     // chunk [s_sent, s_sent+n_sent) poslat u t_sent
+  int* one;                                 // bafer za persistentno slanje jednog taska
+  MPI_Request *one_req, *idle_req;
+  MPI_Request** sreq; int* nsreq;           // Isend-ovi delova poslednjeg stream chunk-a, po rangu
+  // prefetch: workeru čiji se chunk stream-uje odmah ide i sledeći ("ahead"), da mu ulaz stiže dok računa
+  int *a_start, *a_n; Job** a_job;          // [rang] = chunk koji čeka iza tekućeg (a_n==0: nema ga)
+  MPI_Request** asreq; int* nasreq;         // Isend-ovi delova ahead chunk-a
+  int* at; int at_cap;                      // RESULTS_FILE: [start, x...] za TAG_TASK_AT
+  // spekulativno izvršavanje (SPEC=0 isključuje): kad je red prazan, chunk koji kasni ide i idle workeru
+  int spec; double spec_factor, spec_min;   // spec_min: apsolutni minimum kašnjenja u sekundama (SPEC_MIN_MS)
+  int *idle, *copied;                       // [rang] = dobio IDLE / njegov chunk je već dupliran
+  int nidle;
+  double* svc; int nsvc, svc_at;            // prsten poslednjih SPEC_WINDOW vremena po tasku
+  double svc_med;                           // njihova medijana, računa se po rezultatu, ne po pregledu
+  // scale-in: rangovi >= lo se otpuštaju; shrunk[w] = poslat TAG_SHRINK, čeka Comm_split
+  int lo, nshrunk; unsigned char* shrunk;
+  const char* release_path; int keep; double release_t;   // RELEASE_FILE, SCALE_IN_KEEP
+} Farm;
+
+static void farm_init(Farm* F, MPI_Comm C){
+  F->C=C; MPI_Comm_size(C,&F->size);
+  F->jobs=NULL; F->njobs=F->jobs_cap=0; F->jw=calloc(F->size,sizeof(Job*)); F->vclock=0;
+  F->spool=getenv("SPOOL_DIR"); if (F->spool && !*F->spool) F->spool=NULL;
+  F->spool_ms=getenv_int("SPOOL_POLL_MS", 200); F->spool_t=0;
+  F->s_sent=calloc(F->size,sizeof(int)); F->n_sent=calloc(F->size,sizeof(int)); F->t_sent=calloc(F->size,sizeof(double));
+  F->one=calloc(F->size,sizeof(int));
+  F->one_req=malloc(sizeof(MPI_Request)*F->size); F->idle_req=malloc(sizeof(MPI_Request)*F->size);
+  F->sreq=calloc(F->size,sizeof(MPI_Request*)); F->nsreq=calloc(F->size,sizeof(int));
+  F->a_start=calloc(F->size,sizeof(int)); F->a_n=calloc(F->size,sizeof(int)); F->a_job=calloc(F->size,sizeof(Job*));
+  F->asreq=calloc(F->size,sizeof(MPI_Request*)); F->nasreq=calloc(F->size,sizeof(int));
+  F->at=NULL; F->at_cap=0;
+  for (int w=1; w<F->size; ++w){
+    MPI_Send_init(&F->one[w],1,MPI_INT,w,TAG_TASK,C,&F->one_req[w]);
+    MPI_Send_init(NULL,0,MPI_INT,w,TAG_IDLE,C,&F->idle_req[w]);
+  }
+  const char* e=getenv("SPEC"); F->spec = !(e && !strcmp(e,"0"));
+  F->spec_factor = getenv_int("SPEC_FACTOR", 3);
+  F->spec_min = getenv_int("SPEC_MIN_MS", 50) / 1000.0;
+  F->idle=calloc(F->size,sizeof(int)); F->copied=calloc(F->size,sizeof(int));
+  F->nidle=0; F->svc=malloc(sizeof(double)*SPEC_WINDOW); F->nsvc=F->svc_at=0; F->svc_med=0;
+  F->lo=F->size; F->nshrunk=0; F->shrunk=calloc(F->size,1);
+  F->release_path=getenv("RELEASE_FILE"); if (F->release_path && !*F->release_path) F->release_path=NULL;
+  F->keep=getenv_int("SCALE_IN_KEEP", 0); F->release_t=0;
+}
+
+static void farm_free(Farm* F){
+  for (int w=1; w<F->size; ++w){
+    MPI_Request_free(&F->one_req[w]); MPI_Request_free(&F->idle_req[w]);
+    MPI_Waitall(F->nsreq[w],F->sreq[w],MPI_STATUSES_IGNORE); free(F->sreq[w]);
+    MPI_Waitall(F->nasreq[w],F->asreq[w],MPI_STATUSES_IGNORE); free(F->asreq[w]);
+  }
+  free(F->sreq); free(F->nsreq); free(F->asreq); free(F->nasreq);
+  free(F->a_start); free(F->a_n); free(F->a_job);
+  free(F->one_req); free(F->idle_req); free(F->one); free(F->t_sent); free(F->n_sent); free(F->s_sent);
+  free(F->idle); free(F->copied); free(F->svc); free(F->shrunk); free(F->at);
+  for (int j=0; j<F->njobs; ++j) job_free(F->jobs[j]);
+  free(F->jobs); free(F->jw);
+}
+
+// novi posao kreće od trenutnog virtuelnog vremena: ne dobija "kredit" za vreme pre prijema
+static void farm_add_job(Farm* F, Job* J){
+  J->vtime = F->vclock;
+  if (F->njobs==F->jobs_cap){ F->jobs_cap=F->jobs_cap?2*F->jobs_cap:8; F->jobs=realloc(F->jobs,sizeof(Job*)*F->jobs_cap); }
+  F->jobs[F->njobs++] = J;
+}
+
+// weighted fair share (stride): sledeći chunk ide poslu sa najmanjim vtime među onima koji imaju
+// šta da pošalju; jednak vtime → raniji posao. NULL = nema mesta ni u jednom redu.
+static Job* farm_pick(const Farm* F){
+  Job* best=NULL;
+  for (int j=0; j<F->njobs; ++j){
+    Job* J=F->jobs[j];
+    if (job_room(J)>0 && (!best || J->vtime < best->vtime)) best=J;
+  }
+  return best;
+}
+
+// neposlatih taskova u svim redovima (bez obzira na reorder prozor)
+static int farm_queued(const Farm* F){
+  int q=0; for (int j=0; j<F->njobs; ++j) q += F->jobs[j]->NT - F->jobs[j]->next;
+  return q;
+}
+
+// veliki chunk: zaglavlje pa delovi od STREAM_PIECE_BYTES kao Isend (tasks[] živi dok ima referenci);
+// worker drži dva prijema unapred, pa master ne čeka da worker izračuna deo pre slanja sledećeg.
+// *rq/*nrq su zahtevi slota (tekući ili ahead) u koji chunk ide; njihov prethodni chunk je već vraćen.
+static void stream_send(Farm* F, int w, int start, const int* x, int c, MPI_Request** rq, int* nrq){
+  MPI_Waitall(*nrq,*rq,MPI_STATUSES_IGNORE);
+  int piece = g_stream_piece/(int)sizeof(int); if (piece<1) piece=1;
+  int np = (c+piece-1)/piece, hdr[3]={c,piece,start};
+  *rq=realloc(*rq,sizeof(MPI_Request)*np); *nrq=np;
+  MPI_Send(hdr,3,MPI_INT,w,TAG_TASK_STREAM,F->C);
+  for (int k=0;k<np;++k){
+    int off=k*piece, m = c-off<piece ? c-off : piece;
+    MPI_Isend((void*)&x[off],m,MPI_INT,w,TAG_TASK_PIECE,F->C,&(*rq)[k]);
+  }
+}
+
+// chunk ide u delovima: worker to podržava, chunk je dovoljno velik i LZ nije dogovoren
+// (delovi se šalju sirovi, pa kompresija ima prednost — inače COMPRESS=1 ne bi sažimao baš najveće)
+static int stream_ok(int w, int c){
+  return g_in==MPI_FILE_NULL && (get_caps(w)&(CAP_STREAM|CAP_LZ))==CAP_STREAM
+      && (long)c*(long)sizeof(int)>=g_stream_min;
+}
+
+// ahead=1: chunk ide u red iza tekućeg (prefetch); worker ga obrađuje posle tekućeg, istim redom
+static void send_chunk(Farm* F, int w, Job* J, int start, int c, int ahead){
+  J->refs++;
+  if (ahead){ F->a_start[w] = start; F->a_n[w] = c; F->a_job[w] = J; }
+  else {
+    F->s_sent[w] = start; F->n_sent[w] = c; F->t_sent[w] = MPI_Wtime(); F->jw[w] = J;
+    if (F->idle[w]){ F->idle[w]=0; F->nidle--; }
+  }
+  if (g_in!=MPI_FILE_NULL){   // samo opis: worker sam čita [offset, offset+len) iz INPUT_FILE
+    long long r[2] = { (long long)start*(long long)sizeof(int), (long long)c*(long long)sizeof(int) };
+    MPI_Send(r,2,MPI_LONG_LONG,w,TAG_TASK_RANGE,F->C);
+    return;
+  }
+  const int* x = &J->tasks[start];
+  if (stream_ok(w, c)) stream_send(F, w, start, x, c, ahead ? &F->asreq[w] : &F->sreq[w], ahead ? &F->nasreq[w] : &F->nsreq[w]);
+  else if (g_out!=MPI_FILE_NULL){
+    if (c+1>F->at_cap){ F->at_cap=c+1; F->at=realloc(F->at,sizeof(int)*F->at_cap); }
+    F->at[0]=start; memcpy(F->at+1,x,sizeof(int)*c);
+    lz_send_ints(F->at,c+1,w,TAG_TASK_AT,F->C,get_caps(w)&CAP_LZ,g_lz_min);
+  }
+  else if (c==1){ F->one[w]=x[0]; MPI_Start(&F->one_req[w]); MPI_Wait(&F->one_req[w],MPI_STATUS_IGNORE); }
+  else lz_send_ints(x,c,w,TAG_TASK,F->C,get_caps(w)&CAP_LZ,g_lz_min);
+}
+
+static int farm_hold(Farm* F, Sched* S, int w);
+
+// dok se tekući (stream) chunk workera w prenosi i računa, pošalji mu i sledeći: worker već tokom
+// poslednjeg dela preuzima njegovo zaglavlje i prvi deo u slobodan bafer. Samo jedan unapred,
+// i ne tokom scale-in-a (rang mora da ostane bez posla da bi dobio SHRINK).
+static void farm_prefetch(Farm* F, Sched* S, int w){
+  if (F->a_n[w] || !F->jw[w] || F->lo < F->size || !stream_ok(w, F->n_sent[w])) return;
+  Job* J = farm_pick(F);
+  int c = J ? sched_chunk(S, w, job_room(J)) : 0;
+  if (c<=0) return;
+  send_chunk(F, w, J, J->next, c, 1);
+  J->next += c; J->vtime += c / J->weight; F->vclock = J->vtime;
+  m_dispatch(w, c, farm_queued(F));
+}
+
+// rezultat tekućeg je obrađen: ahead chunk postaje tekući (vreme se meri od sada, kad ga worker počinje)
+static int farm_promote(Farm* F, int w){
+  if (!F->a_n[w]) return 0;
+  F->s_sent[w] = F->a_start[w]; F->n_sent[w] = F->a_n[w]; F->jw[w] = F->a_job[w];
+  F->t_sent[w] = MPI_Wtime(); F->copied[w] = 0;
+  MPI_Request* r=F->sreq[w]; F->sreq[w]=F->asreq[w]; F->asreq[w]=r;
+  int n=F->nsreq[w]; F->nsreq[w]=F->nasreq[w]; F->nasreq[w]=n;
+  F->a_n[w] = 0; F->a_job[w] = NULL;
+  return 1;
+}
+
+// pošalji workeru w sledeći chunk (ili IDLE ako su svi redovi prazni); pamti [start, start+c) za rezultat
+static void dispatch(Farm* F, Sched* S, int w){
+  if (F->lo < F->size && farm_hold(F, S, w)) return;
+  Job* J = farm_pick(F);
+  int c = J ? sched_chunk(S, w, job_room(J)) : 0;
+  F->copied[w] = 0;
+  if (c>0){
+    send_chunk(F, w, J, J->next, c, 0);
+    J->next += c; J->vtime += c / J->weight; F->vclock = J->vtime;
+  } else {
+    // prazni redovi → IDLE; puni reorder prozori → worker samo čeka dok ga farm_wake ne probudi
+    F->n_sent[w] = 0;
+    if (farm_queued(F)==0){ MPI_Start(&F->idle_req[w]); MPI_Wait(&F->idle_req[w],MPI_STATUS_IGNORE); }
+    if (!F->idle[w]){ F->idle[w]=1; F->nidle++; }
+  }
+  m_dispatch(w, c, farm_queued(F));
+  if (c>0) farm_prefetch(F, S, w);
+}
+
+// posle pomeranja limit-a ili prijema posla: idle workeri dobijaju posao dok ima mesta
+static void farm_wake(Farm* F, Sched* S){
+  for (int w=1; w<F->size && F->nidle>0 && farm_pick(F); ++w) if (F->idle[w]) dispatch(F, S, w);
+}
+
+// === SCALE-IN: otpuštanje workera usred posla ===
+// Otpuštaju se najviši rangovi (lo..size-1): Comm_split sa key=rang im ne menja rang ostalih, pa
+// nizovi po rangu (Farm, Sched, caps, metrike) ostaju važeći i samo se skraćuju.
+// 1) drain: rangovi >= lo ne dobijaju novi chunk; čim vrate onaj u letu dobijaju TAG_SHRINK{0}
+// 2) kad su svi ispražnjeni, ostali dobijaju TAG_SHRINK{1} umesto sledećeg chunk-a (idle odmah,
+//    zauzeti na svom rezultatu — najviše jedan chunk pauze), pa svi rade split i free starog.
+// Poruke se ne gube: svaki rang dobija SHRINK tek kad master primi njegov poslednji rezultat.
+// U SPAWN režimu otpušteni worker izlazi iz CLUSTER-a odmah, ali MPI_Finalize čeka ostatak svog spawn posla.
+static void farm_split(Farm* F, Sched* S);
+
+static int farm_draining(const Farm* F){
+  for (int w=F->lo; w<F->size; ++w) if (!F->shrunk[w]) return 1;
+  return 0;
+}
+
+static void farm_shrink_one(Farm* F, int w, int keep){
+  if (F->idle[w]){ F->idle[w]=0; F->nidle--; }
+  F->n_sent[w]=0; F->copied[w]=0; F->shrunk[w]=1; F->nshrunk++;
+  MPI_Send(&keep,1,MPI_INT,w,TAG_SHRINK,F->C);
+}
+
+// iz dispatch-a: vraća 1 ako w umesto posla dobija SHRINK (ili ako je split upravo urađen)
+static int farm_hold(Farm* F, Sched* S, int w){
+  if (w >= F->lo) farm_shrink_one(F, w, 0);
+  else if (!farm_draining(F)) farm_shrink_one(F, w, 1);
+  else return 0;
+  if (!farm_draining(F))   // drain gotov: idle zadržani ne čekaju rezultat, SHRINK ide odmah
+    for (int v=1; v<F->lo; ++v) if (!F->shrunk[v] && F->idle[v]) farm_shrink_one(F, v, 1);
+  if (F->nshrunk == F->size-1) farm_split(F, S);
+  return 1;
+}
+
+// započni otpuštanje k najviših rangova (bar jedan worker ostaje)
+static void farm_drain(Farm* F, Sched* S, int k){
+  if (F->lo < F->size || k<=0) return;
+  int lo = F->size-k; if (lo<2) lo=2;
+  if (lo>=F->size) return;
+  F->lo = lo;
+  printf("[MASTER] scale-in: draining ranks %d..%d\n", lo, F->size-1); fflush(stdout);
+  for (int w=1; w<F->size && F->lo<F->size; ++w)
+    if (F->idle[w] && (w>=lo || !farm_draining(F))) farm_hold(F, S, w);
+}
+
+static void farm_split(Farm* F, Sched* S){
+  int old=F->size;
+  for (int w=1; w<old; ++w){
+    MPI_Request_free(&F->one_req[w]); MPI_Request_free(&F->idle_req[w]);
+    MPI_Waitall(F->nsreq[w],F->sreq[w],MPI_STATUSES_IGNORE); F->nsreq[w]=0;
+    MPI_Waitall(F->nasreq[w],F->asreq[w],MPI_STATUSES_IGNORE); F->nasreq[w]=0;
+  }
+  // fajlovi se zatvaraju kolektivno nad starim CLUSTER-om (isti redosled kao u workeru), ostali ih ponovo otvaraju
+  if (g_out!=MPI_FILE_NULL) MPI_File_close(&g_out);
+  if (g_in!=MPI_FILE_NULL) MPI_File_close(&g_in);
+  MPI_Comm NEWC; int rc = MPI_Comm_split(F->C, 0, 0, &NEWC); perr("Comm_split(shrink)", rc);
+  // free, ne disconnect: Open MPI 4.1 zaglavi u Comm_disconnect nad merge-ovanim intrakomunikatorom
+  // (inter-ovi iz prijema se i dalje disconnect-uju); posle free-a master nema vezu sa otpuštenima
+  MPI_Comm_free(&F->C);
+  F->C=NEWC; MPI_Comm_size(NEWC,&F->size);
+  if (g_out_path) g_out = file_open(F->C, g_out_path, OUT_MODE);
+  if (g_in_path)  g_in  = file_open(F->C, g_in_path, IN_MODE);
+  for (int w=1; w<F->size; ++w){
+    MPI_Send_init(&F->one[w],1,MPI_INT,w,TAG_TASK,F->C,&F->one_req[w]);
+    MPI_Send_init(NULL,0,MPI_INT,w,TAG_IDLE,F->C,&F->idle_req[w]);
+  }
+  memset(F->shrunk,0,old); F->nshrunk=0; F->lo=F->size;
+  S->P = F->size-1; S->fact_left = 0;
+  m_workers(F->size, old-F->size);
+  printf("[MASTER] scale-in: released %d worker(s) -> size=%d (workers=%d)\n", old-F->size, F->size, F->size-1); fflush(stdout);
+  for (int w=1; w<F->size; ++w) dispatch(F, S, w);
+}
+
+// na vrhu petlje raspodele: RELEASE_FILE (broj workera za otpuštanje, fajl se troši; proverava se
+// najviše 10x u sekundi) i SCALE_IN_KEEP (red prazan i ništa u letu → ostaje KEEP workera)
+static void farm_check_release(Farm* F, Sched* S){
+  if (F->lo < F->size) return;
+  if (F->keep>0 && farm_queued(F)==0 && F->nidle==F->size-1 && F->size-1 > F->keep){
+    farm_drain(F, S, F->size-1-F->keep); return;
+  }
+  if (!F->release_path || MPI_Wtime()-F->release_t < 0.1) return;
+  F->release_t = MPI_Wtime();
+  FILE* f=fopen(F->release_path,"r"); if (!f) return;
+  int k=0; if (fscanf(f,"%d",&k)!=1) k=0;
+  fclose(f); remove(F->release_path);
+  farm_drain(F, S, k);
+}
+
+static int cmp_double(const void* a, const void* b){
+  double x=*(const double*)a, y=*(const double*)b; return (x>y)-(x<y);
+}
+
+// rezultat chunk-a od w: vraća broj taskova koji su ovde prvi put završeni (ostalo je duplikat)
+static int farm_complete(Farm* F, int w, int n, double elapsed){
+  Job* J=F->jw[w]; int fresh=0;
+  if (!J) return 0;
+  for (int i=0;i<n;++i) if (!J->done[F->s_sent[w]+i]){ J->done[F->s_sent[w]+i]=1; fresh++; }
+  J->ndone += fresh;
+  if (fresh>0 && n>0){
+    F->svc[F->svc_at] = elapsed/n; F->svc_at = (F->svc_at+1)%SPEC_WINDOW;
+    if (F->nsvc<SPEC_WINDOW) F->nsvc++;
+    double tmp[SPEC_WINDOW]; memcpy(tmp,F->svc,sizeof(double)*F->nsvc);
+    qsort(tmp,F->nsvc,sizeof(double),cmp_double);
+    F->svc_med = tmp[F->nsvc/2];
+  }
+  return fresh;
+}
+
+// posle obrade rezultata: w više ne drži posao; završen posao bez referenci izlazi iz liste
+static void farm_retire(Farm* F, int w){
+  Job* J=F->jw[w]; F->jw[w]=NULL;
+  if (!J) return;
+  // stream Isend-ovi pokazuju u J->tasks: završi ih pre nego što job_free može da ga oslobodi
+  // (rezultat je stigao, pa je worker sve delove već primio i Waitall ne čeka)
+  MPI_Waitall(F->nsreq[w],F->sreq[w],MPI_STATUSES_IGNORE); F->nsreq[w]=0;
+  J->refs--;
+  if (J->ndone==J->NT && !J->finished) job_finish(J);
+  if (!J->finished || J->refs>0) return;
+  for (int j=0; j<F->njobs; ++j) if (F->jobs[j]==J){ F->jobs[j]=F->jobs[--F->njobs]; break; }
+  job_free(J);
+}
+
+// ima li chunk-a u letu čiji rezultat još nije stigao ni od originala ni od kopije
+static int farm_pending(const Farm* F){
+  for (int w=1; w<F->size; ++w) if (F->jw[w] && F->n_sent[w]>0 && !F->jw[w]->done[F->s_sent[w]]) return 1;
+  return 0;
+}
+
+// ima li ijednog chunk-a u letu (uključujući i one čiji je rezultat već stigao od kopije)
+static int farm_inflight(const Farm* F){
+  for (int w=1; w<F->size; ++w) if (F->jw[w]) return 1;
+  return 0;
+}
+
+// nema šta da se pošalje (redovi prazni ili puni reorder prozori) i ima idle workera: chunk koji je u letu
+// duže od SPEC_FACTOR × medijana × veličina (i nije već dupliran) šalje se i jednom idle workeru;
+// medijana je po tasku, pa bi mali chunk na repu (1 task) delovao višestruko zakasnelo samo zbog
+// fiksne latencije poruke — zato mora da kasni i bar SPEC_MIN_MS (default 50).
+// vraća 1 ako je nešto poslato
+static int speculate(Farm* F){
+  if (!F->spec || F->nidle==0 || F->nsvc==0 || farm_pick(F) || !farm_pending(F)) return 0;
+  double med=F->svc_med;
+
+  double now=MPI_Wtime(), worst=0; int slow=-1;
+  for (int w=1; w<F->size; ++w){
+    if (!F->jw[w] || F->n_sent[w]==0 || F->copied[w] || F->jw[w]->done[F->s_sent[w]]) continue;
+    if (now-F->t_sent[w] < F->spec_min) continue;
+    double late = (now-F->t_sent[w]) / (med*F->n_sent[w]);
+    if (late > F->spec_factor && late > worst){ worst=late; slow=w; }
+  }
+  if (slow<0) return 0;
+  int v=1; while (v<F->size && !F->idle[v]) v++;
+  if (v>=F->size) return 0;
+
+  F->copied[slow] = F->copied[v] = 1;     // original i kopija se više ne dupliraju
+  send_chunk(F, v, F->jw[slow], F->s_sent[slow], F->n_sent[slow], 0);
+  m_speculate(v, F->n_sent[slow]);
+  printf("[MASTER] speculative: tasks [%d,%d) of rank %d (%.1fx median) -> rank %d\n",
+         F->s_sent[slow], F->s_sent[slow]+F->n_sent[slow], slow, worst, v); fflush(stdout);
+  return 1;
+}
+
+// SPOOL_DIR: novi <ime>.job se preuzima preimenovanjem u <ime>.run (dva mastera ne uzimaju isti
+// posao); pregled najviše na SPOOL_POLL_MS (default 200). Idle workeri odmah dobijaju posao.
+static void farm_poll_spool(Farm* F, Sched* S){
+  if (!F->spool || (MPI_Wtime()-F->spool_t)*1000 < F->spool_ms) return;
+  F->spool_t = MPI_Wtime();
+  DIR* d=opendir(F->spool); if (!d) return;
+  struct dirent* e; int added=0;
+  while ((e=readdir(d))){
+    size_t n=strlen(e->d_name);
+    if (n<=4 || n>=256 || strcmp(e->d_name+n-4,".job")) continue;
+    char name[256]; snprintf(name,sizeof name,"%.*s",(int)(n-4),e->d_name);
+    char src[1024], run[1024];
+    snprintf(src,sizeof src,"%s/%s",F->spool,e->d_name);
+    snprintf(run,sizeof run,"%s/%s.run",F->spool,name);
+    if (rename(src,run)!=0) continue;
+    Job* J=job_load(F->spool, name);
+    if (!J){ fprintf(stderr,"[MASTER] spool: %s nije učitan\n", run); continue; }
+    farm_add_job(F, J);
+    printf("[MASTER] job %s: %d tasks, weight %g (active jobs=%d)\n", J->name, J->NT, J->weight, F->njobs); fflush(stdout);
+    if (J->NT==0){ job_finish(J); F->jobs[--F->njobs]=NULL; job_free(J); }
+    added++;
+  }
+  closedir(d);
+  if (added) farm_wake(F, S);
+}
+
+int main(int argc,char**argv){
+  int provided=MPI_THREAD_SINGLE; MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&provided);
+  metrics_init(provided>=MPI_THREAD_FUNNELED);   // izvozna nit ne zove MPI, ali živi uz MPI proces
+
+  const int TARGET = getenv_int("TARGET_WORKERS", 1);
+  const char* HOSTFILE = getenv("SPAWN_HOSTFILE"); if (HOSTFILE && !*HOSTFILE) HOSTFILE=NULL;
+  const int SPAWN = getenv_int("SPAWN_WORKERS", 0);
+  // COMPRESS=1 uključuje LZ za ovaj posao; COMPRESS_MIN_BYTES drži male poruke van kompresije
+  g_offer  = getenv_int("COMPRESS", 0) ? CAP_LZ : 0;
+  g_lz_min = getenv_int("COMPRESS_MIN_BYTES", 4096);
+  // chunk-ovi >= STREAM_MIN_BYTES idu u delovima (STREAM=0 isključuje); to je put za višemegabajtne
+  // ulaze, pa se uključuje tek uz veliki SCHED_MAX_CHUNK (default 1024 taska = 4 KiB ne stream-uje)
+  { const char* e=getenv("STREAM"); if (!(e && !strcmp(e,"0"))) g_offer |= CAP_STREAM; }
+  g_stream_min   = getenv_int("STREAM_MIN_BYTES", 1<<20);
+  g_stream_piece = getenv_int("STREAM_PIECE_BYTES", 256<<10);
+
+  char PORT[MPI_MAX_PORT_NAME]; PORT[0]='\0';
+  MPI_Comm CLUSTER;
+
+  if (SPAWN>0 || HOSTFILE){
+    // === SPAWN režim: bez ompi-server-a, port.txt i admission rundi ===
+    double t0=MPI_Wtime();
+    CLUSTER = spawn_cluster(SPAWN, HOSTFILE);
+    int s; MPI_Comm_size(CLUSTER,&s);
+    m_admission(MPI_Wtime()-t0, 1);
+    printf("[MASTER] spawned -> size=%d (workers=%d) in %.3fs\n", s, s-1, MPI_Wtime()-t0); fflush(stdout);
+  } else {
+    CLUSTER = port_admission(PORT, TARGET);
+  }
+
+  int size, rank; MPI_Comm_size(CLUSTER,&size); MPI_Comm_rank(CLUSTER,&rank);
+  metrics_start(size);
+  if (size > 1){
+    Sched S; sched_init(&S, size);
+    Farm F; farm_init(&F, CLUSTER);
+    g_out_path = getenv("RESULTS_FILE"); if (g_out_path && !*g_out_path) g_out_path=NULL;
+    if (g_out_path && F.spool){ fprintf(stderr,"[MASTER] RESULTS_FILE se ne koristi uz SPOOL_DIR (svaki posao ima <ime>.out)\n"); g_out_path=NULL; }
+    if (g_out_path && S.kind==SCHED_SINGLE){
+      // jedan write_at po tasku je red veličine sporiji od računanja → chunk-ovi moraju biti veći
+      fprintf(stderr,"[MASTER] RESULTS_FILE uz SCHED=single bi pisao task po task, koristim SCHED=guided\n");
+      S.kind = SCHED_GUIDED;
+    }
+    if (g_out_path){ MPI_File_delete((char*)g_out_path, MPI_INFO_NULL); g_out = file_start(CLUSTER, TAG_OUTPUT, g_out_path, OUT_MODE); }
+    if (F.spool){
+      // === VIŠE POSLOVA: isti CLUSTER služi svaki <ime>.job iz SPOOL_DIR (prijem se plaća jednom) ===
+      printf("[MASTER] sched=%s spool=%s workers=%d\n", sched_name(S.kind), F.spool, S.P); fflush(stdout);
+    } else {
+      // === TASK-FARM DEMO ===  (NUM_TASKS taskova: 2, 3, 4, ... ili ceo INPUT_FILE)
+      int NT = getenv_int("NUM_TASKS", 9);
+      int* tasks = NULL;
+      g_in_path = getenv("INPUT_FILE"); if (g_in_path && !*g_in_path) g_in_path=NULL;
+      if (g_in_path){
+        // master ulaz ne čita: zna samo veličinu, pa je taskova onoliko koliko int32 zapisa ima u fajlu
+        g_in = file_start(CLUSTER, TAG_INPUT, g_in_path, IN_MODE);
+        MPI_Offset bytes=0; MPI_File_get_size(g_in,&bytes);
+        NT = (int)(bytes/(MPI_Offset)sizeof(int));
+      } else {
+        tasks = malloc(sizeof(int)*NT);
+        for (int i=0;i<NT;++i) tasks[i] = i+2;
+      }
+      Job* J = job_new("", tasks, NT, 1); farm_add_job(&F, J);
+      printf("[MASTER] sched=%s tasks=%d workers=%d%s\n", sched_name(S.kind), NT, S.P, J->R.on ? " ordered" : ""); fflush(stdout);
+    }
+    int rcap = S.max_chunk; int* res = malloc(sizeof(int)*rcap);
+
+    // inicijalno: svima po chunk ili IDLE
+    for (int w=1; w<size; ++w) dispatch(&F, &S, w);
+
+    // glavna petlja raspodele: rezultat = y[] za ceo chunk, x uzimamo iz jw[w]->tasks[s_sent[w]..]
+    // Mprobe/Mrecv: poruka se uparuje jednom, bez drugog prolaza kroz matching.
+    // Na repu posla (red prazan, ima idle workera i chunk-ova u letu) blokirajući probe bi čekao
+    // baš na spore rangove, pa se tada radi Improbe + provera stragglera (isto i uz RELEASE_FILE /
+    // SPOOL_DIR, da se zahtev za otpuštanje ili novi posao vidi i kad su svi workeri idle).
+    // Posle scale-in-a F.C je novi CLUSTER.
+    int nap = 200;   // µs sna posle praznog Improbe-a kad ništa nije u letu; raste do IDLE_NAP_MAX_US
+    for(;;){
+      MPI_Status st; MPI_Message msg;
+      farm_check_release(&F, &S);
+      farm_poll_spool(&F, &S);
+      int tail = F.spec && F.nidle>0 && !farm_pick(&F) && farm_pending(&F);
+      if (F.release_path || F.spool || tail){
+        int flag=0;
+        MPI_Improbe(MPI_ANY_SOURCE,MPI_ANY_TAG,F.C,&flag,&msg,&st);
+        if (!flag){
+          if (tail && speculate(&F)) continue;
+          // chunk u letu → bez sna, rezultat se uzima čim stigne (release/spool provere su ionako
+          // ograničene vremenom, pa je prazan krug samo Improbe); sched_yield prepušta jezgro workeru
+          // kad ih ima više od jezgara. Farma bez posla → san se udvostručava
+          if (farm_inflight(&F)){ nap = 200; sched_yield(); continue; }
+          usleep(nap); if (nap < IDLE_NAP_MAX_US) nap *= 2;
+          continue;
+        }
+        nap = 200;
+      } else
+        MPI_Mprobe(MPI_ANY_SOURCE,MPI_ANY_TAG,F.C,&msg,&st);
+      int w = st.MPI_SOURCE;
+      int written = st.MPI_TAG==TAG_WRITTEN;   // RESULTS_FILE: worker je već upisao n rezultata
+      if (((st.MPI_TAG & ~TAG_LZ) != TAG_RESULT && !written) || !F.jw[w]){ MPI_Mrecv(NULL,0,MPI_INT,&msg,MPI_STATUS_IGNORE); continue; }
+      int n = 0;
+      if (written) MPI_Mrecv(&n,1,MPI_INT,&msg,MPI_STATUS_IGNORE);
+      else n = lz_recv_ints(&msg, &st, &res, &rcap);
+      if (n<0) n=0;
+      double dt = MPI_Wtime()-F.t_sent[w];
+      sched_observe(&S, w, F.n_sent[w], dt);
+      // prvi rezultat pobeđuje: taskovi koje je već vratila kopija (ili original) se ne ispisuju ponovo
+      Job* J = F.jw[w];
+      int first = F.s_sent[w], seen = J->done[first];
+      int fresh = farm_complete(&F, w, n, dt);
+      m_complete(w, fresh, dt);
+      if (seen) printf("[MASTER] duplicate result for tasks [%d,%d) from %d discarded\n", first, first+n, w);
+      else if (written) {}
+      else if (J->R.on) for (int i=0;i<n;++i) reorder_put(&J->R, first+i, res[i], w);
+      else for (int i=0;i<n;++i) job_emit(J, first+i, res[i], w);
+      int moved = J->R.on && reorder_flush(&J->R, J)>0;
+      if (moved) J->limit = J->R.emit + J->R.W;
+      farm_retire(&F, w);   // posle ovoga J može biti oslobođen
+      fflush(stdout);
+      if (farm_promote(&F, w)) farm_prefetch(&F, &S, w);
+      else dispatch(&F, &S, w);
+      if (moved) farm_wake(&F, &S);
+    }
+    farm_free(&F);
+    CLUSTER = F.C;
+  }
+  metrics_stop();
+
+  if (PORT[0]) MPI_Close_port(PORT);
+  MPI_Comm_free(&CLUSTER);
+  MPI_Finalize();
+  return 0;
+}
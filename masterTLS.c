@@ -1,254 +1,861 @@
-// master.c — admission master: jedan ciklus za sve talase (nema posebnog prvog).
-// Build: mpicc -O2 -std=gnu11 -o master master.c
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include <sodium.h>
-
-enum {
-    TAG_TASK   = 10,
-    TAG_RESULT = 11,
-    TAG_IDLE   = 13
-};
-
-enum {
-    TAG_AUTH_CLIENT_HELLO = 90,
-    TAG_AUTH_SERVER_HELLO = 91,
-    TAG_AUTH_PROOF        = 92,
-    TAG_AUTH_RESULT       = 93
-};
-
-typedef struct {
-    int worker_id;
-    int nonce_client;
-} AuthClientHello;
-
-typedef struct {
-    int nonce_server;
-} AuthServerHello;
-
-typedef struct {
-    int worker_id;
-    int nonce_client;
-    int nonce_server;
-    int proof;
-} AuthProof;
-
-// "session key" koji dobijamo iz fake TLS handshaka
-
-#define MAX_PROCS 128
-static int g_session_keys[MAX_PROCS];  // po rangu u CLUSTER-u
-
-static void perr(const char *where, int rc)
-{
-    if (rc == MPI_SUCCESS)
-        return;
-    char es[256];
-    int n = 0;
-    MPI_Error_string(rc, es, &n);
-    fprintf(stderr, "[MASTER] %s rc=%d (%s)\n", where, rc, es);
-    fflush(stderr);
-}
-
-static int getenv_int(const char *k, int defv)
-{
-    const char *s = getenv(k);
-    if (!s || !*s)
-        return defv;
-    int v = atoi(s);
-    return v > 0 ? v : defv;
-}
-
-// Bcast(more,len,port): ako more=0, len=0 i port se ne šalje.
-static void bcast_more_and_port(MPI_Comm C, int more, const char *port)
-{
-    int len = more ? ((int)strlen(port) + 1) : 0;
-    MPI_Bcast(&more, 1, MPI_INT, 0, C);
-    MPI_Bcast(&len,  1, MPI_INT, 0, C);
-    if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
-        MPI_Bcast((void *)port, len, MPI_CHAR, 0, C);
-}
-
-// za sada "šifrovanje" = XOR sa g_session_key
-static void secure_send_task(int x, int dest, MPI_Comm comm)
-{
-int key = g_session_keys[dest];       // ključ za TAJ rank
-    int enc = x ^ key;
-    MPI_Send(&enc, 1, MPI_INT, dest, TAG_TASK, comm);
-}
-
-int main(int argc, char **argv)
-{
-    MPI_Init(&argc, &argv);
-    srand((unsigned)time(NULL));
-
-    const int TARGET = getenv_int("TARGET_WORKERS", 1);
-
-    // 1) Otvori port i objavi ga (stdout + port.txt)
-    char PORT[MPI_MAX_PORT_NAME];
-    int rc = MPI_Open_port(MPI_INFO_NULL, PORT);
-    perr("Open_port", rc);
-    if (rc != MPI_SUCCESS)
-        MPI_Abort(MPI_COMM_WORLD, 1);
-
-    printf("%s\n", PORT);
-    fflush(stdout);
-    {
-        FILE *f = fopen("port.txt", "w");
-        if (f) {
-            fprintf(f, "%s\n", PORT);
-            fclose(f);
-        }
-    }
-
-    // 2) CLUSTER = COMM_SELF (posle svakog merge-a raste)
-    MPI_Comm CLUSTER;
-    rc = MPI_Comm_dup(MPI_COMM_SELF, &CLUSTER);
-    perr("Comm_dup(self)", rc);
-
-    int added    = 0;
-    int accept_it = 1;
-
-    // 3) Admission runde: isti kod za prvi i sve sledeće talase
-    while (added < TARGET)
-    {
-        printf("%d\n", added);
-        fflush(stdout);
-
-        // poravnanje runde sa trenutnim CLUSTER-om
-        MPI_Barrier(CLUSTER);
-
-        // najavi da primamo još (more=1) i podeli port
-        bcast_more_and_port(CLUSTER, /*more=*/1, PORT);
-
-        // kolektivni accept preko CLUSTER-a (prvi put učestvuje samo master)
-        MPI_Comm inter;
-        printf("Pre ACCEPT\n");
-        fflush(stdout);
-
-        rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, CLUSTER, &inter);
-        perr("Comm_accept", rc);
-        printf("posle ACCEPT\n");
-        fflush(stdout);
-
-        // === FAKE "TLS" HANDSHAKE: MASTER STRANA ===
-        AuthClientHello ch;
-        AuthServerHello sh;
-        AuthProof p;
-
-        // 1) Primi ClientHello od root-a nove grupe (remote rank 0)
-        rc = MPI_Recv(&ch, sizeof(ch), MPI_BYTE, 0, TAG_AUTH_CLIENT_HELLO, inter, MPI_STATUS_IGNORE);
-        perr("Recv(AUTH_CLIENT_HELLO)", rc);
-
-        // 2) Generiši server nonce i pošalji ServerHello
-        sh.nonce_server = rand();
-
-        rc = MPI_Send(&sh, sizeof(sh), MPI_BYTE, 0, TAG_AUTH_SERVER_HELLO, inter);
-        perr("Send(AUTH_SERVER_HELLO)", rc);
-
-        // 3) Primi proof od workera
-        rc = MPI_Recv(&p, sizeof(p), MPI_BYTE, 0, TAG_AUTH_PROOF, inter, MPI_STATUS_IGNORE);
-        perr("Recv(AUTH_PROOF)", rc);
-
-        // 4) Proveri proof
-        int SECRET   = 0x12345678;   // isti kao u worker.c
-        int expected = ch.nonce_client ^ sh.nonce_server ^ SECRET;
-
-        accept_it = (p.worker_id    == ch.worker_id) &&
-                    (p.nonce_client == ch.nonce_client) &&
-                    (p.nonce_server == sh.nonce_server) &&
-                    (p.proof        == expected);
-
-        // 5) Pošalji rezultat novom root-u
-        rc = MPI_Send(&accept_it, 1, MPI_INT, 0, TAG_AUTH_RESULT, inter);
-        perr("Send(AUTH_RESULT)", rc);
-
-        // 6) Broadcast odluke svim starim članovima CLUSTER-a
-        MPI_Bcast(&accept_it, 1, MPI_INT, 0, CLUSTER);
-
-        if (!accept_it)
-        {
-            // AUTH odbijen → svi u CLUSTER-u rade DISCONNECT nad istim inter
-            MPI_Comm_disconnect(&inter);
-
-            // poravnanje kraja runde
-            MPI_Barrier(CLUSTER);
-            printf("AUTH FAILED, rejecting wave\n");
-            fflush(stdout);
-            continue; // bez merge-a u ovoj rundi
-        }
-
-        // ako smo stigli ovde, auth je prošao → možemo da računamo session key
-       int pending_K = ch.nonce_client ^ sh.nonce_server ^ SECRET;
-printf("[MASTER] session key (pending) = 0x%x for worker_id=%d\n", pending_K, ch.worker_id);
-fflush(stdout);
-
-        // NEMA barijere na "inter" — merge je već kolektivan
-        MPI_Comm CL_NEW;
-        rc = MPI_Intercomm_merge(inter, /*high master*/ 0, &CL_NEW);
-        perr("Intercomm_merge", rc);
-        MPI_Comm_disconnect(&inter);
-
-        // zameni CLUSTER i javi novu veličinu
-        MPI_Comm_free(&CLUSTER);
-        CLUSTER = CL_NEW;
-        int s;
-        MPI_Comm_size(CLUSTER, &s);
-        // pretpostavka: u ovoj rundi je došao TAČNO jedan novi worker → on je rank = s-1
-int new_rank = s - 1;
-g_session_keys[new_rank] = pending_K;
-
-        printf("[MASTER] merged wave -> size=%d (workers=%d)\n", s, s - 1);
-        fflush(stdout);
-        added++;
-    }
-
-    printf("USAAOOOOO\n");
-    fflush(stdout);
-
-    // (opciono) zatvori port da kasniji connect ne visi
-    MPI_Barrier(CLUSTER);
-    bcast_more_and_port(CLUSTER, /*more=*/0, /*port=*/NULL);
-    MPI_Close_port(PORT);
-
-    // 4) Demo task-farm
-    int tasks[] = {2, 3, 4, 5, 6, 7, 8, 9, 10};
-    int NT   = (int)(sizeof(tasks) / sizeof(tasks[0]));
-    int next = 0;
-
-    int size, rank;
-    MPI_Comm_size(CLUSTER, &size);
-    MPI_Comm_rank(CLUSTER, &rank);
-
-    if (size > 1)
-    {
-        // inicijalna raspodela
-        for (int w = 1; w < size; ++w)
-            if (next < NT)
-                secure_send_task(tasks[next++], w, CLUSTER);  // ŠIFROVANO SLANJE
-            else
-                MPI_Send(NULL, 0, MPI_INT, w, TAG_IDLE, CLUSTER);
-
-        // glavna petlja
-        for (;;)
-        {
-            int pair[2];
-            MPI_Status st;
-            MPI_Recv(pair, 2, MPI_INT, MPI_ANY_SOURCE, TAG_RESULT, CLUSTER, &st);
-            printf("[MASTER] result: %d -> %d (from %d)\n",
-                   pair[0], pair[1], st.MPI_SOURCE);
-            fflush(stdout);
-
-            if (next < NT)
-                secure_send_task(tasks[next++], st.MPI_SOURCE, CLUSTER); // opet šifrovano
-            else
-                MPI_Send(NULL, 0, MPI_INT, st.MPI_SOURCE, TAG_IDLE, CLUSTER);
-        }
-    }
-
-    MPI_Comm_free(&CLUSTER);
-    MPI_Finalize();
-    return 0;
-}
+// master.c — admission master: jedan ciklus za sve talase (nema posebnog prvog).
+// Build: mpicc -O2 -std=gnu11 -pthread -o master masterTLS.c -lsodium
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sodium.h>
+#include "metrics.h"
+
+enum {
+    TAG_TASK   = 10,
+    TAG_RESULT = 11,
+    TAG_IDLE   = 13
+};
+
+enum {
+    TAG_AUTH_CLIENT_HELLO = 90,
+    TAG_AUTH_SERVER_HELLO = 91,
+    TAG_AUTH_PROOF        = 92,
+    TAG_AUTH_RESULT       = 93,
+    TAG_ADMIT_MODE        = 94,  // posle uspešnog handshaka: kako se worker priključuje
+    TAG_JOIN_INFO         = 95,  // lobby → kandidat: join port + jednokratni token
+    TAG_JOIN_TOKEN        = 96,  // kandidat → master na join portu: token iz lobby-ja
+    TAG_AUTH_TICKET       = 97,  // posle uspešnog handshaka: novi resumption ticket
+    TAG_AUTH_BINDER       = 98,  // resumed: dokaz da klijent ima session key iz ticketa
+    TAG_JOIN_READY        = 99   // kandidat → lobby: token, odmah pre connect-a na join port
+};
+
+// AuthClientHello.flags
+enum {
+    HELLO_WANT_TICKET = 0x1,   // worker čuva ticket (TICKET_FILE) → master ga izdaje
+    HELLO_HAS_TICKET  = 0x2    // ch.ticket je popunjen → pokušaj resumption
+};
+
+// ADMISSION=star: master sam prihvata na MPI_COMM_SELF i čuva po jedan inter po workeru;
+// postojeći workeri ne učestvuju u kasnijim prijemima. Default je kolektivni accept + merge.
+enum {
+    ADMIT_COLLECTIVE = 0,
+    ADMIT_STAR       = 1,
+    ADMIT_LOBBY      = 2   // LOBBY=1: handshake je prošao u lobby-ju, kandidat prelazi na join port
+};
+
+// sadržaj ticketa; worker ga vidi samo šifrovanog
+typedef struct {
+    int32_t serial;
+    int32_t session_key;
+    int64_t issued;
+    int64_t expires;
+} TicketBody;
+
+typedef struct {
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    unsigned char box[crypto_secretbox_MACBYTES + sizeof(TicketBody)];
+} ResumeTicket;
+
+typedef struct {
+    int worker_id;
+    int nonce_client;
+    int flags;
+    ResumeTicket ticket;
+} AuthClientHello;
+
+// binder = secretbox(nonce_client || nonce_server) ključem iz session key-a ticketa;
+// sam ticket (vidljiv u ClientHello) bez tog ključa ne otvara sesiju
+typedef struct {
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    unsigned char box[crypto_secretbox_MACBYTES + 2 * sizeof(int)];
+} ResumeBinder;
+
+typedef struct {
+    int nonce_server;
+    int resumed;   // 1: ticket prihvaćen, Proof/Result se preskaču
+} AuthServerHello;
+
+typedef struct {
+    int worker_id;
+    int nonce_client;
+    int nonce_server;
+    int proof;
+} AuthProof;
+
+typedef struct {
+    int  token;
+    char port[MPI_MAX_PORT_NAME];
+} JoinInfo;
+
+// "session key" koji dobijamo iz fake TLS handshaka
+
+#define MAX_PROCS 128
+static int g_session_keys[MAX_PROCS];  // po rangu u CLUSTER-u
+
+static void perr(const char *where, int rc)
+{
+    if (rc == MPI_SUCCESS)
+        return;
+    char es[256];
+    int n = 0;
+    MPI_Error_string(rc, es, &n);
+    fprintf(stderr, "[MASTER] %s rc=%d (%s)\n", where, rc, es);
+    fflush(stderr);
+}
+
+static int getenv_int(const char *k, int defv)
+{
+    const char *s = getenv(k);
+    if (!s || !*s)
+        return defv;
+    int v = atoi(s);
+    return v > 0 ? v : defv;
+}
+
+// Bcast(more,len,port): ako more=0, len=0 i port se ne šalje.
+static void bcast_more_and_port(MPI_Comm C, int more, const char *port)
+{
+    int len = more ? ((int)strlen(port) + 1) : 0;
+    MPI_Bcast(&more, 1, MPI_INT, 0, C);
+    MPI_Bcast(&len,  1, MPI_INT, 0, C);
+    if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
+        MPI_Bcast((void *)port, len, MPI_CHAR, 0, C);
+}
+
+// za sada "šifrovanje" = XOR sa g_session_key
+// slanje ide kroz persistentni zahtev tog ranga (MPI_Send_init nad enc_buf[dest])
+static void secure_send_task(int x, int dest, int *enc_buf, MPI_Request *task_req)
+{
+int key = g_session_keys[dest];       // ključ za TAJ rank
+    enc_buf[dest] = x ^ key;
+    MPI_Start(&task_req[dest]);
+    MPI_Wait(&task_req[dest], MPI_STATUS_IGNORE);
+}
+
+// Recv sa rokom: timeout_s <= 0 je običan blokirajući Recv.
+// Vraća 1 ako je poruka stigla, 0 ako je rok istekao (zahtev je otkazan).
+static int recv_timeout(void *buf, int count, MPI_Datatype type, int src, int tag, MPI_Comm comm, double timeout_s)
+{
+    if (timeout_s <= 0)
+    {
+        int rc = MPI_Recv(buf, count, type, src, tag, comm, MPI_STATUS_IGNORE);
+        return rc == MPI_SUCCESS;
+    }
+    MPI_Request req;
+    MPI_Irecv(buf, count, type, src, tag, comm, &req);
+    double deadline = MPI_Wtime() + timeout_s;
+    int done = 0;
+    for (;;)
+    {
+        MPI_Test(&req, &done, MPI_STATUS_IGNORE);
+        if (done)
+            return 1;
+        if (MPI_Wtime() > deadline)
+            break;
+        usleep(1000);
+    }
+    MPI_Cancel(&req);
+    MPI_Wait(&req, MPI_STATUS_IGNORE);
+    return 0;
+}
+
+// === RESUMPTION TICKET ===
+// Ticket = TicketBody šifrovan crypto_secretbox-om ključem koji postoji samo u memoriji mastera.
+// Jednokratan je: svaki uspešan handshake (pun ili resumed) izdaje novi, a iskorišćeni se poništava.
+// Opoziv: TICKET_REVOKE_FILE sa serijskim brojevima (jedan po liniji), čita se pri svakoj proveri.
+// Rok je isti za sve tickete, pa ističu redom serijskih brojeva: pamte se samo oni od g_ticket_base.
+static unsigned char g_ticket_key[crypto_secretbox_KEYBYTES];
+static int g_ticket_ttl = 3600;
+static int g_ticket_serial = 0;          // poslednji izdat serijski broj
+static int g_ticket_base = 1;            // serijski brojevi < base su istekli
+static unsigned char *g_ticket_used;     // [serial - base] = 1 posle iskorišćenja
+static int64_t *g_ticket_expires;        // [serial - base] = kada ticket ističe
+static const char *g_revoke_file;
+
+static void ticket_init(void)
+{
+    if (sodium_init() < 0)
+    {
+        fprintf(stderr, "[MASTER] sodium_init failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    randombytes_buf(g_ticket_key, sizeof(g_ticket_key));
+    g_ticket_ttl  = getenv_int("TICKET_TTL_S", 3600);
+    g_revoke_file = getenv("TICKET_REVOKE_FILE");
+}
+
+// izbaci istekle tickete sa početka (ticket_redeem ih ionako odbija po roku iz TicketBody)
+static void ticket_prune(void)
+{
+    int64_t now = (int64_t)time(NULL);
+    int live = g_ticket_serial - g_ticket_base + 1;
+    int k = 0;
+    while (k < live && g_ticket_expires[k] <= now)
+        k++;
+    if (k == 0)
+        return;
+    memmove(g_ticket_used, g_ticket_used + k, live - k);
+    memmove(g_ticket_expires, g_ticket_expires + k, sizeof(int64_t) * (live - k));
+    g_ticket_base += k;
+}
+
+static void ticket_issue(int session_key, ResumeTicket *t)
+{
+    ticket_prune();
+
+    TicketBody b;
+    b.serial      = ++g_ticket_serial;
+    b.session_key = session_key;
+    b.issued      = (int64_t)time(NULL);
+    b.expires     = b.issued + g_ticket_ttl;
+
+    int live = g_ticket_serial - g_ticket_base + 1;
+    g_ticket_used    = realloc(g_ticket_used, live);
+    g_ticket_expires = realloc(g_ticket_expires, sizeof(int64_t) * live);
+    g_ticket_used[live - 1]    = 0;
+    g_ticket_expires[live - 1] = b.expires;
+
+    randombytes_buf(t->nonce, sizeof(t->nonce));
+    crypto_secretbox_easy(t->box, (const unsigned char *)&b, sizeof(b), t->nonce, g_ticket_key);
+}
+
+static int ticket_revoked(int serial)
+{
+    if (g_ticket_used[serial - g_ticket_base])
+        return 1;
+    if (!g_revoke_file)
+        return 0;
+    FILE *f = fopen(g_revoke_file, "r");
+    if (!f)
+        return 0;
+    char line[64];
+    int hit = 0;
+    while (!hit && fgets(line, sizeof(line), f))
+        hit = (line[0] != '#' && atoi(line) == serial);
+    fclose(f);
+    return hit;
+}
+
+// vraća 1 i session key iz ticketa ako je ticket autentičan, neistekao i neopozvan
+static int ticket_redeem(const ResumeTicket *t, int *key_out)
+{
+    TicketBody b;
+    if (crypto_secretbox_open_easy((unsigned char *)&b, t->box, sizeof(t->box), t->nonce, g_ticket_key) != 0)
+        return 0;
+    if (b.serial <= 0 || b.serial > g_ticket_serial)
+        return 0;
+    ticket_prune();
+    if (b.serial < g_ticket_base || (int64_t)time(NULL) >= b.expires || ticket_revoked(b.serial))
+    {
+        printf("[MASTER] ticket #%d expired or revoked\n", b.serial);
+        fflush(stdout);
+        return 0;
+    }
+    // poništava se i ako binder posle ne prođe: ukradeni ticket daje najviše jedan pokušaj
+    g_ticket_used[b.serial - g_ticket_base] = 1;
+    *key_out = b.session_key;
+    return 1;
+}
+
+// binder mora da otvori ključ izveden iz session key-a ticketa i da sadrži baš nonce-ove ove sesije
+static int binder_check(const ResumeBinder *rb, int session_key, int nonce_client, int nonce_server)
+{
+    unsigned char key[crypto_secretbox_KEYBYTES];
+    int n[2];
+    memset(key, 0, sizeof(key));
+    memcpy(key, &session_key, sizeof(session_key));
+    if (crypto_secretbox_open_easy((unsigned char *)n, rb->box, sizeof(rb->box), rb->nonce, key) != 0)
+        return 0;
+    return n[0] == nonce_client && n[1] == nonce_server;
+}
+
+// === FAKE "TLS" HANDSHAKE: MASTER STRANA ===
+// peer = rank u udaljenoj grupi inter-a; vraća accept_it, a u *key_out session key.
+// Sa timeout_s > 0 (lobby) vraća -1 ako klijent ne odgovori na vreme.
+static int server_handshake(MPI_Comm inter, int peer, int *key_out, double timeout_s)
+{
+    int rc;
+    AuthClientHello ch;
+    AuthServerHello sh;
+    AuthProof p;
+
+    // 1) Primi ClientHello od root-a nove grupe (remote rank peer)
+    *key_out = 0;
+    if (!recv_timeout(&ch, sizeof(ch), MPI_BYTE, peer, TAG_AUTH_CLIENT_HELLO, inter, timeout_s))
+        return -1;
+
+    // 2) Generiši server nonce i pošalji ServerHello; važeći ticket → resumed: umesto proof-a binder
+    int K = 0;
+    sh.nonce_server = rand();
+    sh.resumed = (ch.flags & HELLO_HAS_TICKET) && ticket_redeem(&ch.ticket, &K);
+
+    rc = MPI_Send(&sh, sizeof(sh), MPI_BYTE, peer, TAG_AUTH_SERVER_HELLO, inter);
+    perr("Send(AUTH_SERVER_HELLO)", rc);
+
+    int accept_it = 1;
+    if (sh.resumed)
+    {
+        // 3') binder: klijent dokazuje da zna session key iz ticketa (ponovljen ticket ga ne zna)
+        ResumeBinder rb;
+        if (!recv_timeout(&rb, sizeof(rb), MPI_BYTE, peer, TAG_AUTH_BINDER, inter, timeout_s))
+            return -1;
+        accept_it = binder_check(&rb, K, ch.nonce_client, sh.nonce_server);
+        if (!accept_it)
+        {
+            printf("[MASTER] resumption binder invalid, ticket rejected\n");
+            fflush(stdout);
+        }
+        rc = MPI_Send(&accept_it, 1, MPI_INT, peer, TAG_AUTH_RESULT, inter);
+        perr("Send(AUTH_RESULT)", rc);
+
+        // novi session key iz starog (iz ticketa) i svežih nonce-ova
+        K ^= ch.nonce_client ^ sh.nonce_server;
+    }
+    else
+    {
+        // 3) Primi proof od workera
+        if (!recv_timeout(&p, sizeof(p), MPI_BYTE, peer, TAG_AUTH_PROOF, inter, timeout_s))
+            return -1;
+
+        // 4) Proveri proof
+        int SECRET   = 0x12345678;   // isti kao u worker.c
+        int expected = ch.nonce_client ^ sh.nonce_server ^ SECRET;
+
+        accept_it = (p.worker_id    == ch.worker_id) &&
+                    (p.nonce_client == ch.nonce_client) &&
+                    (p.nonce_server == sh.nonce_server) &&
+                    (p.proof        == expected);
+
+        // 5) Pošalji rezultat novom root-u
+        rc = MPI_Send(&accept_it, 1, MPI_INT, peer, TAG_AUTH_RESULT, inter);
+        perr("Send(AUTH_RESULT)", rc);
+        K = expected;
+    }
+
+    *key_out = accept_it ? K : 0;
+
+    // 6) Novi (jednokratni) ticket za sledeće priključivanje
+    if (accept_it && (ch.flags & HELLO_WANT_TICKET))
+    {
+        ResumeTicket t;
+        ticket_issue(K, &t);
+        rc = MPI_Send(&t, sizeof(t), MPI_BYTE, peer, TAG_AUTH_TICKET, inter);
+        perr("Send(AUTH_TICKET)", rc);
+        printf("[MASTER] ticket #%d issued (%s handshake)\n", g_ticket_serial, sh.resumed ? "resumed" : "full");
+        fflush(stdout);
+    }
+    return accept_it;
+}
+
+// LOBBY: master sam (MPI_COMM_SELF) prihvata kandidate na lobby portu i radi handshake sa rokom.
+// Odbijeni ili spori kandidati ne koštaju CLUSTER ništa; prihvaćeni dobija join port i token.
+// CLUSTER ulazi u kolektivni accept tek kad kandidat u roku potvrdi (JOIN_READY) da kreće na join port;
+// kandidat koji se ne javi ispada ovde, umesto da zaglavi accept za sve koji dolaze posle njega.
+// Vraća token koji kandidat mora da pošalje na join portu, a u *key_out njegov session key.
+static int lobby_admit(const char *LPORT, const char *JPORT, double timeout_s, int *key_out)
+{
+    for (;;)
+    {
+        MPI_Comm inter;
+        int rc = MPI_Comm_accept(LPORT, MPI_INFO_NULL, 0, MPI_COMM_SELF, &inter);
+        perr("Comm_accept(lobby)", rc);
+
+        int ok = server_handshake(inter, 0, key_out, timeout_s);
+        if (ok != 1)
+        {
+            printf("[MASTER] lobby: %s, candidate dropped\n", ok < 0 ? "handshake timeout" : "AUTH FAILED");
+            fflush(stdout);
+            // spor klijent možda nikad ne pozove disconnect → samo lokalno oslobađanje
+            if (ok < 0)
+                MPI_Comm_free(&inter);
+            else
+                MPI_Comm_disconnect(&inter);
+            continue;
+        }
+
+        JoinInfo ji;
+        memset(&ji, 0, sizeof(ji));
+        ji.token = rand() | 1;   // 0 nikad nije važeći token
+        snprintf(ji.port, sizeof(ji.port), "%s", JPORT);
+
+        int mode = ADMIT_LOBBY;
+        rc = MPI_Send(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter);
+        perr("Send(ADMIT_MODE)", rc);
+        rc = MPI_Send(&ji, sizeof(ji), MPI_BYTE, 0, TAG_JOIN_INFO, inter);
+        perr("Send(JOIN_INFO)", rc);
+
+        int ready = 0;
+        if (!recv_timeout(&ready, 1, MPI_INT, 0, TAG_JOIN_READY, inter, timeout_s) || ready != ji.token)
+        {
+            printf("[MASTER] lobby: join not confirmed in time, candidate dropped\n");
+            fflush(stdout);
+            MPI_Comm_free(&inter);
+            continue;
+        }
+        MPI_Comm_disconnect(&inter);
+        return ji.token;
+    }
+}
+
+// port režim: ompi-server + port.txt, kolektivne admission runde sa handshakom.
+// LOBBY != 0: u port.txt ide lobby port, a join port znaju samo kandidati koji su prošli handshake.
+static MPI_Comm port_admission(int TARGET, int LOBBY, double timeout_s)
+{
+    char PORT[MPI_MAX_PORT_NAME];
+    char LPORT[MPI_MAX_PORT_NAME];
+    // 1) Otvori port(ove) i objavi javni (stdout + port.txt)
+    int rc = MPI_Open_port(MPI_INFO_NULL, PORT);
+    perr("Open_port", rc);
+    if (rc != MPI_SUCCESS)
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    if (LOBBY)
+    {
+        rc = MPI_Open_port(MPI_INFO_NULL, LPORT);
+        perr("Open_port(lobby)", rc);
+        if (rc != MPI_SUCCESS)
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    const char *PUBLIC = LOBBY ? LPORT : PORT;
+
+    printf("%s\n", PUBLIC);
+    fflush(stdout);
+    {
+        FILE *f = fopen("port.txt", "w");
+        if (f) {
+            fprintf(f, "%s\n", PUBLIC);
+            fclose(f);
+        }
+    }
+
+    // 2) CLUSTER = COMM_SELF (posle svakog merge-a raste)
+    MPI_Comm CLUSTER;
+    rc = MPI_Comm_dup(MPI_COMM_SELF, &CLUSTER);
+    perr("Comm_dup(self)", rc);
+
+    int added    = 0;
+    int accept_it = 1;
+
+    // 3) Admission runde: isti kod za prvi i sve sledeće talase
+    while (added < TARGET)
+    {
+        printf("%d\n", added);
+        fflush(stdout);
+
+        // lobby: čekamo verifikovanog kandidata pre nego što iko iz CLUSTER-a uđe u rundu
+        int token = 0, pending_K = 0;
+        if (LOBBY)
+            token = lobby_admit(LPORT, PORT, timeout_s, &pending_K);
+
+        // poravnanje runde sa trenutnim CLUSTER-om
+        MPI_Barrier(CLUSTER);
+
+        // najavi da primamo još (more=1) i podeli port
+        bcast_more_and_port(CLUSTER, /*more=*/1, PORT);
+
+        // kolektivni accept preko CLUSTER-a (prvi put učestvuje samo master)
+        MPI_Comm inter;
+        printf("Pre ACCEPT\n");
+        fflush(stdout);
+
+        rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, CLUSTER, &inter);
+        perr("Comm_accept", rc);
+        double t_round = MPI_Wtime();
+        printf("posle ACCEPT\n");
+        fflush(stdout);
+
+        if (LOBBY)
+        {
+            // handshake je već prošao u lobby-ju; ovde se samo proverava token
+            int t = 0;
+            recv_timeout(&t, 1, MPI_INT, 0, TAG_JOIN_TOKEN, inter, timeout_s);
+            accept_it = (t == token);
+            rc = MPI_Send(&accept_it, 1, MPI_INT, 0, TAG_AUTH_RESULT, inter);
+            perr("Send(AUTH_RESULT)", rc);
+        }
+        else
+            accept_it = server_handshake(inter, 0, &pending_K, 0);
+
+        // 6) Broadcast odluke svim starim članovima CLUSTER-a
+        MPI_Bcast(&accept_it, 1, MPI_INT, 0, CLUSTER);
+
+        if (!accept_it)
+        {
+            // AUTH odbijen → svi u CLUSTER-u rade DISCONNECT nad istim inter
+            MPI_Comm_disconnect(&inter);
+
+            // poravnanje kraja runde
+            MPI_Barrier(CLUSTER);
+            m_admission(MPI_Wtime() - t_round, 0);
+            printf("AUTH FAILED, rejecting wave\n");
+            fflush(stdout);
+            continue; // bez merge-a u ovoj rundi
+        }
+
+        // ako smo stigli ovde, auth je prošao → session key je već izračunat u handshaku
+printf("[MASTER] session key (pending) = 0x%x\n", pending_K);
+fflush(stdout);
+        int mode = ADMIT_COLLECTIVE;
+        rc = MPI_Send(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter);
+        perr("Send(ADMIT_MODE)", rc);
+
+        // NEMA barijere na "inter" — merge je već kolektivan
+        MPI_Comm CL_NEW;
+        rc = MPI_Intercomm_merge(inter, /*high master*/ 0, &CL_NEW);
+        perr("Intercomm_merge", rc);
+        MPI_Comm_disconnect(&inter);
+
+        // zameni CLUSTER i javi novu veličinu
+        MPI_Comm_free(&CLUSTER);
+        CLUSTER = CL_NEW;
+        int s;
+        MPI_Comm_size(CLUSTER, &s);
+        // pretpostavka: u ovoj rundi je došao TAČNO jedan novi worker → on je rank = s-1
+int new_rank = s - 1;
+g_session_keys[new_rank] = pending_K;
+        m_admission(MPI_Wtime() - t_round, 1);
+
+        printf("[MASTER] merged wave -> size=%d (workers=%d)\n", s, s - 1);
+        fflush(stdout);
+        added++;
+    }
+
+    printf("USAAOOOOO\n");
+    fflush(stdout);
+
+    // (opciono) zatvori port da kasniji connect ne visi
+    MPI_Barrier(CLUSTER);
+    bcast_more_and_port(CLUSTER, /*more=*/0, /*port=*/NULL);
+    MPI_Close_port(PORT);
+    if (LOBBY)
+        MPI_Close_port(LPORT);
+
+    return CLUSTER;
+}
+
+// star režim: accept samo na MPI_COMM_SELF, bez Barrier/Bcast/merge nad CLUSTER-om.
+// W[i] je inter ka i-tom workeru (on je remote rank 0), ključ mu je g_session_keys[i+1].
+static void star_admission(int TARGET, MPI_Comm *W)
+{
+    char PORT[MPI_MAX_PORT_NAME];
+    int rc = MPI_Open_port(MPI_INFO_NULL, PORT);
+    perr("Open_port", rc);
+    if (rc != MPI_SUCCESS)
+        MPI_Abort(MPI_COMM_WORLD, 1);
+
+    printf("%s\n", PORT);
+    fflush(stdout);
+    {
+        FILE *f = fopen("port.txt", "w");
+        if (f) {
+            fprintf(f, "%s\n", PORT);
+            fclose(f);
+        }
+    }
+
+    int added = 0;
+    while (added < TARGET)
+    {
+        MPI_Comm inter;
+        double t0 = MPI_Wtime();
+        rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, MPI_COMM_SELF, &inter);
+        perr("Comm_accept(star)", rc);
+        double t_round = MPI_Wtime();
+
+        int K = 0;
+        if (!server_handshake(inter, 0, &K, 0))
+        {
+            MPI_Comm_disconnect(&inter);
+            m_admission(MPI_Wtime() - t_round, 0);
+            printf("AUTH FAILED, rejecting worker\n");
+            fflush(stdout);
+            continue;
+        }
+
+        int mode = ADMIT_STAR;
+        rc = MPI_Send(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter);
+        perr("Send(ADMIT_MODE)", rc);
+
+        W[added] = inter;
+        g_session_keys[added + 1] = K;
+        added++;
+        m_admission(MPI_Wtime() - t_round, 1);
+        printf("[MASTER] star: worker %d admitted in %.3fs (workers=%d)\n", added, MPI_Wtime() - t0, added);
+        fflush(stdout);
+    }
+
+    MPI_Close_port(PORT);
+}
+
+// SPAWN_HOSTFILE: linije "host [slots=N]", '#' je komentar; vraća broj hostova
+#define MAX_SPAWN_HOSTS 256
+static int read_hostfile(const char *path, char hosts[][256], int *slots)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror("[MASTER] fopen(SPAWN_HOSTFILE)");
+        return 0;
+    }
+    int n = 0;
+    char line[512];
+    while (n < MAX_SPAWN_HOSTS && fgets(line, sizeof line, f))
+    {
+        char *h = strtok(line, " \t\r\n");
+        if (!h || h[0] == '#')
+            continue;
+        snprintf(hosts[n], 256, "%s", h);
+        slots[n] = 1;
+        for (char *t = strtok(NULL, " \t\r\n"); t; t = strtok(NULL, " \t\r\n"))
+        {
+            if (t[0] == '#')
+                break;
+            if (!strncmp(t, "slots=", 6) && atoi(t + 6) > 0)
+                slots[n] = atoi(t + 6);
+        }
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+// SPAWN režim: jedan MPI_Comm_spawn_multiple + jedan merge, bez porta i admission rundi.
+// Handshake je opcion (SPAWN_AUTH=0 ga gasi); deca dobijaju režim kroz argv.
+// Odbijeni učestvuju u merge/split (kolektivni su) ali ne ulaze u CLUSTER.
+static MPI_Comm spawn_cluster(int count, const char *hostfile, int auth)
+{
+    const char *bin = getenv("WORKER_BIN");
+    if (!bin || !*bin)
+        bin = "./worker";
+    static char hosts[MAX_SPAWN_HOSTS][256];
+    static int slots[MAX_SPAWN_HOSTS];
+    int nh   = hostfile ? read_hostfile(hostfile, hosts, slots) : 0;
+    int ncmd = nh > 0 ? nh : 1;
+    if (nh == 0 && count <= 0)
+    {
+        fprintf(stderr, "[MASTER] spawn: prazan hostfile i SPAWN_WORKERS=0\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    char *child_argv[] = {auth ? "AUTH" : "NOAUTH", NULL};
+    char **cmds     = malloc(sizeof(char *) * ncmd);
+    char ***argvs   = malloc(sizeof(char **) * ncmd);
+    int *maxprocs   = malloc(sizeof(int) * ncmd);
+    MPI_Info *infos = malloc(sizeof(MPI_Info) * ncmd);
+    int total = 0;
+    for (int i = 0; i < ncmd; ++i)
+    {
+        cmds[i]  = (char *)bin;
+        argvs[i] = child_argv;
+        if (nh > 0) {
+            maxprocs[i] = slots[i];
+            MPI_Info_create(&infos[i]);
+            MPI_Info_set(infos[i], "host", hosts[i]);
+        } else {
+            maxprocs[i] = count;
+            infos[i]    = MPI_INFO_NULL;
+        }
+        total += maxprocs[i];
+    }
+    if (total >= MAX_PROCS)
+    {
+        fprintf(stderr, "[MASTER] spawn: %d workera > MAX_PROCS-1\n", total);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int *errs = malloc(sizeof(int) * total);
+    MPI_Comm inter;
+    int rc = MPI_Comm_spawn_multiple(ncmd, cmds, argvs, maxprocs, infos, 0, MPI_COMM_SELF, &inter, errs);
+    perr("Comm_spawn_multiple", rc);
+    if (rc != MPI_SUCCESS)
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    for (int i = 0; i < total; ++i)
+        perr("spawn(child)", errs[i]);
+
+    // handshake sa svakim detetom redom (remote rank i)
+    int *ok  = malloc(sizeof(int) * total);
+    int *key = malloc(sizeof(int) * total);
+    for (int i = 0; i < total; ++i)
+    {
+        ok[i] = auth ? server_handshake(inter, i, &key[i], 0) : 1;
+        if (!auth)
+            key[i] = 0; // XOR sa 0 = plain tekst
+        if (!ok[i]) {
+            printf("AUTH FAILED for spawned child %d\n", i);
+            fflush(stdout);
+        }
+    }
+
+    // split nad inter-om izbacuje odbijene, pa merge: prihvaćeni redom dobijaju rank 1..
+    MPI_Comm SUB, CLUSTER;
+    rc = MPI_Comm_split(inter, 0, 0, &SUB);
+    perr("Comm_split(spawn)", rc);
+    rc = MPI_Intercomm_merge(SUB, /*high master*/ 0, &CLUSTER);
+    perr("Intercomm_merge(spawn)", rc);
+    MPI_Comm_free(&SUB);
+    MPI_Comm_disconnect(&inter);
+
+    int r = 1;
+    for (int i = 0; i < total; ++i)
+        if (ok[i])
+            g_session_keys[r++] = key[i];
+
+    for (int i = 0; i < ncmd; ++i)
+        if (infos[i] != MPI_INFO_NULL)
+            MPI_Info_free(&infos[i]);
+    free(key); free(ok); free(errs); free(infos); free(maxprocs); free(argvs); free(cmds);
+    return CLUSTER;
+}
+
+int main(int argc, char **argv)
+{
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    srand((unsigned)time(NULL));
+    ticket_init();
+    metrics_init(provided >= MPI_THREAD_FUNNELED);
+
+    const int TARGET = getenv_int("TARGET_WORKERS", 1);
+
+    const char *HOSTFILE = getenv("SPAWN_HOSTFILE");
+    if (HOSTFILE && !*HOSTFILE)
+        HOSTFILE = NULL;
+    const int SPAWN = getenv_int("SPAWN_WORKERS", 0);
+
+    const char *adm = getenv("ADMISSION");
+    const int STAR = adm && !strcmp(adm, "star") && !(SPAWN > 0 || HOSTFILE);
+
+    MPI_Comm CLUSTER = MPI_COMM_NULL;
+    MPI_Comm *W = NULL;   // star: inter po workeru
+    int size;
+    if (SPAWN > 0 || HOSTFILE)
+    {
+        const char *a = getenv("SPAWN_AUTH");
+        int auth = !(a && !strcmp(a, "0"));
+        double t0 = MPI_Wtime();
+        CLUSTER = spawn_cluster(SPAWN, HOSTFILE, auth);
+        m_admission(MPI_Wtime() - t0, 1);
+        int s;
+        MPI_Comm_size(CLUSTER, &s);
+        printf("[MASTER] spawned -> size=%d (workers=%d, auth=%d) in %.3fs\n", s, s - 1, auth, MPI_Wtime() - t0);
+        fflush(stdout);
+    }
+    else if (STAR)
+    {
+        if (TARGET >= MAX_PROCS)
+        {
+            fprintf(stderr, "[MASTER] star: TARGET_WORKERS=%d > MAX_PROCS-1\n", TARGET);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        W = malloc(sizeof(MPI_Comm) * TARGET);
+        star_admission(TARGET, W);
+    }
+    else
+    {
+        const int LOBBY = getenv_int("LOBBY", 0);
+        const double timeout_s = getenv_int("AUTH_TIMEOUT_MS", 2000) / 1000.0;
+        CLUSTER = port_admission(TARGET, LOBBY, timeout_s);
+    }
+
+    // 4) Demo task-farm
+    int tasks[] = {2, 3, 4, 5, 6, 7, 8, 9, 10};
+    int NT   = (int)(sizeof(tasks) / sizeof(tasks[0]));
+    int next = 0;
+
+    // worker w (1..size-1) je dest_of[w] u comm_of[w]: rank w u CLUSTER-u, ili rank 0 u W[w-1]
+    if (STAR)
+        size = TARGET + 1;
+    else
+        MPI_Comm_size(CLUSTER, &size);
+    MPI_Comm *comm_of = malloc(sizeof(MPI_Comm) * size);
+    int *dest_of = malloc(sizeof(int) * size);
+    for (int w = 1; w < size; ++w)
+    {
+        comm_of[w] = STAR ? W[w - 1] : CLUSTER;
+        dest_of[w] = STAR ? 0 : w;
+    }
+    metrics_start(size);
+
+    if (size > 1)
+    {
+        // sve poruke farme su fiksnog oblika → persistentni zahtevi, napravljeni jednom;
+        // rezultat se čeka po workeru (Waitany), što radi i preko zasebnih inter-a
+        int *enc_buf = calloc(size, sizeof(int));
+        int *pairs   = calloc(2 * size, sizeof(int));
+        MPI_Request *task_req = malloc(sizeof(MPI_Request) * size);
+        MPI_Request *idle_req = malloc(sizeof(MPI_Request) * size);
+        MPI_Request *res_req  = malloc(sizeof(MPI_Request) * (size - 1));
+        double *t_sent = calloc(size, sizeof(double));   // za service-time metrike
+        for (int w = 1; w < size; ++w)
+        {
+            MPI_Send_init(&enc_buf[w], 1, MPI_INT, dest_of[w], TAG_TASK, comm_of[w], &task_req[w]);
+            MPI_Send_init(NULL, 0, MPI_INT, dest_of[w], TAG_IDLE, comm_of[w], &idle_req[w]);
+            MPI_Recv_init(&pairs[2 * w], 2, MPI_INT, dest_of[w], TAG_RESULT, comm_of[w], &res_req[w - 1]);
+        }
+        MPI_Startall(size - 1, res_req);
+
+        // inicijalna raspodela
+        for (int w = 1; w < size; ++w)
+            if (next < NT)
+            {
+                t_sent[w] = MPI_Wtime();
+                secure_send_task(tasks[next++], w, enc_buf, task_req);  // ŠIFROVANO SLANJE
+                m_dispatch(w, 1, NT - next);
+            }
+            else
+            {
+                MPI_Start(&idle_req[w]);
+                MPI_Wait(&idle_req[w], MPI_STATUS_IGNORE);
+            }
+
+        // glavna petlja
+        for (;;)
+        {
+            int idx;
+            MPI_Waitany(size - 1, res_req, &idx, MPI_STATUS_IGNORE);
+            int w = idx + 1;
+            m_complete(w, 1, MPI_Wtime() - t_sent[w]);
+            printf("[MASTER] result: %d -> %d (from %d)\n",
+                   pairs[2 * w], pairs[2 * w + 1], w);
+            fflush(stdout);
+            MPI_Start(&res_req[idx]);
+
+            if (next < NT)
+            {
+                t_sent[w] = MPI_Wtime();
+                secure_send_task(tasks[next++], w, enc_buf, task_req); // opet šifrovano
+                m_dispatch(w, 1, NT - next);
+            }
+            else
+            {
+                MPI_Start(&idle_req[w]);
+                MPI_Wait(&idle_req[w], MPI_STATUS_IGNORE);
+            }
+        }
+
+        for (int w = 1; w < size; ++w)
+        {
+            MPI_Request_free(&task_req[w]);
+            MPI_Request_free(&idle_req[w]);
+        }
+        free(t_sent);
+        free(res_req);
+        free(idle_req);
+        free(task_req);
+        free(pairs);
+        free(enc_buf);
+    }
+
+    free(dest_of);
+    free(comm_of);
+    metrics_stop();
+    if (STAR)
+    {
+        for (int i = 0; i < TARGET; ++i)
+            MPI_Comm_disconnect(&W[i]);
+        free(W);
+        MPI_Finalize();
+        return 0;
+    }
+    MPI_Comm_free(&CLUSTER);
+    MPI_Finalize();
+    return 0;
+}
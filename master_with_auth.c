@@ -1,183 +1,394 @@
-// master.c — admission master: jedan ciklus za sve talase (nema posebnog prvog).
-// Build: mpicc -O2 -std=gnu11 -o master master.c
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-enum
-{
-    TAG_TASK = 10,
-    TAG_RESULT = 11,
-    TAG_IDLE = 13
-};
-enum
-{
-    TAG_AUTH = 90,
-    TAG_AUTH_REPLY = 91
-};
-static void perr(const char *where, int rc)
-{
-    if (rc == MPI_SUCCESS)
-        return;
-    char es[256];
-    int n = 0;
-    MPI_Error_string(rc, es, &n);
-    fprintf(stderr, "[MASTER] %s rc=%d (%s)\n", where, rc, es);
-    fflush(stderr);
-}
-static int getenv_int(const char *k, int defv)
-{
-    const char *s = getenv(k);
-    if (!s || !*s)
-        return defv;
-    int v = atoi(s);
-    return v > 0 ? v : defv;
-}
-// Bcast(more,len,port): ako more=0, len=0 i port se ne šalje.
-static void bcast_more_and_port(MPI_Comm C, int more, const char *port)
-{
-    int len = more ? ((int)strlen(port) + 1) : 0;
-    MPI_Bcast(&more, 1, MPI_INT, 0, C);
-    MPI_Bcast(&len, 1, MPI_INT, 0, C);
-    if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
-        MPI_Bcast((void *)port, len, MPI_CHAR, 0, C);
-}
-static void bcast_auth_decision(MPI_Comm C, int accept_it)
-{
-    int rc = MPI_Bcast(&accept_it, 1, MPI_INT, 0, C);
-    perr("Bcast(auth_decision)", rc);
-}
-
-int main(int argc, char **argv)
-{
-    MPI_Init(&argc, &argv);
-    const int REQUIRED_MAGIC = 5;
-    const int TARGET = getenv_int("TARGET_WORKERS", 1);
-
-    // 1) Otvori port i objavi ga (stdout + port.txt)
-    char PORT[MPI_MAX_PORT_NAME];
-    int rc = MPI_Open_port(MPI_INFO_NULL, PORT);
-    perr("Open_port", rc);
-    if (rc != MPI_SUCCESS)
-        MPI_Abort(MPI_COMM_WORLD, 1);
-    printf("%s\n", PORT);
-    fflush(stdout);
-    {
-        FILE *f = fopen("port.txt", "w");
-        if (f)
-        {
-            fprintf(f, "%s\n", PORT);
-            fclose(f);
-        }
-    }
-
-    // 2) CLUSTER = COMM_SELF (posle svakog merge-a raste)
-    MPI_Comm CLUSTER;
-    rc = MPI_Comm_dup(MPI_COMM_SELF, &CLUSTER);
-    perr("Comm_dup(self)", rc);
-
-    int added = 0;
-int accept_it=1;
-    // 3) Admission runde: isti kod za prvi i sve sledeće talase
-    while (added < TARGET)
-    {
-  printf( "%d\n",added);
-          fflush(stdout);
-        // poravnanje runde sa trenutnim CLUSTER-om
-         if (accept_it){
-        MPI_Barrier(CLUSTER);
-
-        // najavi da primamo još (more=1) i podeli port
-      
-         }  bcast_more_and_port(CLUSTER, /*more=*/1, PORT);
-        // kolektivni accept preko CLUSTER-a (prvi put učestvuje samo master)
-        MPI_Comm inter;
-printf("Pre ACCEPT");
-            fflush(stdout);
-        rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, CLUSTER, &inter);
-        perr("Comm_accept", rc);
-        printf("posle ACCEPT");
-            fflush(stdout);
-             accept_it = 0;
-            int magic = -1;
-            MPI_Recv(&magic, 1, MPI_INT, 0, TAG_AUTH, inter, MPI_STATUS_IGNORE);
-            accept_it = (magic == REQUIRED_MAGIC);
-
-            // 2) pošalji reply novom (AUTH_REPLY)
-            MPI_Send(&accept_it, 1, MPI_INT, 0, TAG_AUTH_REPLY, inter);
-
-            // 3) OBAVEZNO: broadcast odluke SVIM članovima CLUSTER-a u OVOJ RUNDI
-          MPI_Bcast(&accept_it, 1, MPI_INT, 0, CLUSTER);
-
-            if (!accept_it)
-            {
-                // 4a) svi lokalni (master + stari workeri) rade DISCONNECT nad istim inter
-                MPI_Comm_disconnect(&inter);
-  
-                // 5) poravnanje kraja runde
-                MPI_Barrier(CLUSTER);
-                  printf("Prosao bcast barijeru");
-            fflush(stdout);
-                continue; // bez merge-a u ovoj rundi
-            }
-        else{
-    printf("usao u");
-            fflush(stdout);
-        // NEMA barijere na "inter" — merge je već kolektivan
-        MPI_Comm CL_NEW;
-        rc = MPI_Intercomm_merge(inter, /*high master*/ 0, &CL_NEW);
-        perr("Intercomm_merge", rc);
-        MPI_Comm_disconnect(&inter);
-
-        // zameni CLUSTER i javi novu veličinu
-        MPI_Comm_free(&CLUSTER);
-        CLUSTER = CL_NEW;
-        int s;
-        MPI_Comm_size(CLUSTER, &s);
-        printf("[MASTER] merged wave -> size=%d (workers=%d)\n", s, s - 1);
-        fflush(stdout);
-        added++;}
-    }
-    printf("USAAOOOOO");
-    fflush(stdout);
-    // (opciono) zatvori port da kasniji connect ne visi
-    MPI_Barrier(CLUSTER);
-    bcast_more_and_port(CLUSTER, /*more=*/0, /*port=*/NULL);
-
-    MPI_Close_port(PORT);
-
-    // 4) Demo task-farm
-    int tasks[] = {2, 3, 4, 5, 6, 7, 8, 9, 10};
-    int NT = (int)(sizeof(tasks) / sizeof(tasks[0]));
-    int next = 0;
-
-    int size, rank;
-    MPI_Comm_size(CLUSTER, &size);
-    MPI_Comm_rank(CLUSTER, &rank);
-    if (size > 1)
-    {
-        for (int w = 1; w < size; ++w)
-            if (next < NT)
-                MPI_Send(&tasks[next++], 1, MPI_INT, w, TAG_TASK, CLUSTER);
-            else
-                MPI_Send(NULL, 0, MPI_INT, w, TAG_IDLE, CLUSTER);
-
-        for (;;)
-        {
-            int pair[2];
-            MPI_Status st;
-            MPI_Recv(pair, 2, MPI_INT, MPI_ANY_SOURCE, TAG_RESULT, CLUSTER, &st);
-            printf("[MASTER] result: %d -> %d (from %d)\n", pair[0], pair[1], st.MPI_SOURCE);
-            fflush(stdout);
-            if (next < NT)
-                MPI_Send(&tasks[next++], 1, MPI_INT, st.MPI_SOURCE, TAG_TASK, CLUSTER);
-            else
-                MPI_Send(NULL, 0, MPI_INT, st.MPI_SOURCE, TAG_IDLE, CLUSTER);
-        }
-    }
-
-    MPI_Comm_free(&CLUSTER);
-    MPI_Finalize();
-    return 0;
-}
+// master.c — admission master: jedan ciklus za sve talase (nema posebnog prvog).
+// Build: mpicc -O2 -std=gnu11 -o master master.c
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum
+{
+    TAG_TASK = 10,
+    TAG_RESULT = 11,
+    TAG_IDLE = 13
+};
+enum
+{
+    TAG_AUTH = 90,
+    TAG_AUTH_REPLY = 91,
+    TAG_ADMIT_MODE = 92, // posle prihvatanja: kolektivni merge ili star
+    TAG_JOIN_INFO = 93,  // lobby → kandidat: join port + jednokratni token
+    TAG_JOIN_TOKEN = 94, // kandidat → master na join portu: token iz lobby-ja
+    TAG_JOIN_READY = 95  // kandidat → lobby: token, odmah pre connect-a na join port
+};
+// ADMISSION=star: master prihvata sam (MPI_COMM_SELF) i čuva po jedan inter po workeru,
+// postojeći workeri ne učestvuju u kasnijim prijemima.
+enum
+{
+    ADMIT_COLLECTIVE = 0,
+    ADMIT_STAR = 1,
+    ADMIT_LOBBY = 2 // LOBBY=1: auth je prošao u lobby-ju, kandidat prelazi na join port
+};
+typedef struct
+{
+    int token;
+    char port[MPI_MAX_PORT_NAME];
+} JoinInfo;
+static void perr(const char *where, int rc)
+{
+    if (rc == MPI_SUCCESS)
+        return;
+    char es[256];
+    int n = 0;
+    MPI_Error_string(rc, es, &n);
+    fprintf(stderr, "[MASTER] %s rc=%d (%s)\n", where, rc, es);
+    fflush(stderr);
+}
+static int getenv_int(const char *k, int defv)
+{
+    const char *s = getenv(k);
+    if (!s || !*s)
+        return defv;
+    int v = atoi(s);
+    return v > 0 ? v : defv;
+}
+// Bcast(more,len,port): ako more=0, len=0 i port se ne šalje.
+static void bcast_more_and_port(MPI_Comm C, int more, const char *port)
+{
+    int len = more ? ((int)strlen(port) + 1) : 0;
+    MPI_Bcast(&more, 1, MPI_INT, 0, C);
+    MPI_Bcast(&len, 1, MPI_INT, 0, C);
+    if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
+        MPI_Bcast((void *)port, len, MPI_CHAR, 0, C);
+}
+static void bcast_auth_decision(MPI_Comm C, int accept_it)
+{
+    int rc = MPI_Bcast(&accept_it, 1, MPI_INT, 0, C);
+    perr("Bcast(auth_decision)", rc);
+}
+// Recv sa rokom: timeout_s <= 0 je običan blokirajući Recv.
+// Vraća 1 ako je poruka stigla, 0 ako je rok istekao (zahtev je otkazan).
+static int recv_timeout(void *buf, int count, MPI_Datatype type, int src, int tag, MPI_Comm comm, double timeout_s)
+{
+    if (timeout_s <= 0)
+        return MPI_Recv(buf, count, type, src, tag, comm, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+    MPI_Request req;
+    MPI_Irecv(buf, count, type, src, tag, comm, &req);
+    double deadline = MPI_Wtime() + timeout_s;
+    int done = 0;
+    for (;;)
+    {
+        MPI_Test(&req, &done, MPI_STATUS_IGNORE);
+        if (done)
+            return 1;
+        if (MPI_Wtime() > deadline)
+            break;
+        usleep(1000);
+    }
+    MPI_Cancel(&req);
+    MPI_Wait(&req, MPI_STATUS_IGNORE);
+    return 0;
+}
+
+// LOBBY: master sam (MPI_COMM_SELF) prihvata kandidate na lobby portu i proverava magic sa rokom.
+// Odbijeni ili spori kandidati ne koštaju CLUSTER ništa; prihvaćeni dobija join port i token.
+// CLUSTER ulazi u kolektivni accept tek kad kandidat u roku potvrdi (JOIN_READY) da kreće na join port;
+// kandidat koji se ne javi ispada ovde, umesto da zaglavi accept za sve koji dolaze posle njega.
+static int lobby_admit(const char *LPORT, const char *JPORT, int REQUIRED_MAGIC, double timeout_s)
+{
+    for (;;)
+    {
+        MPI_Comm inter;
+        int rc = MPI_Comm_accept(LPORT, MPI_INFO_NULL, 0, MPI_COMM_SELF, &inter);
+        perr("Comm_accept(lobby)", rc);
+
+        int magic = -1;
+        if (!recv_timeout(&magic, 1, MPI_INT, 0, TAG_AUTH, inter, timeout_s))
+        {
+            // spor klijent možda nikad ne pozove disconnect → samo lokalno oslobađanje
+            MPI_Comm_free(&inter);
+            printf("[MASTER] lobby: auth timeout, candidate dropped\n");
+            fflush(stdout);
+            continue;
+        }
+        int accept_it = (magic == REQUIRED_MAGIC);
+        MPI_Send(&accept_it, 1, MPI_INT, 0, TAG_AUTH_REPLY, inter);
+        if (!accept_it)
+        {
+            MPI_Comm_disconnect(&inter);
+            printf("[MASTER] lobby: AUTH FAILED, candidate dropped\n");
+            fflush(stdout);
+            continue;
+        }
+
+        JoinInfo ji;
+        memset(&ji, 0, sizeof(ji));
+        ji.token = rand() | 1; // 0 nikad nije važeći token
+        snprintf(ji.port, sizeof(ji.port), "%s", JPORT);
+
+        int mode = ADMIT_LOBBY;
+        MPI_Send(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter);
+        MPI_Send(&ji, sizeof(ji), MPI_BYTE, 0, TAG_JOIN_INFO, inter);
+
+        int ready = 0;
+        if (!recv_timeout(&ready, 1, MPI_INT, 0, TAG_JOIN_READY, inter, timeout_s) || ready != ji.token)
+        {
+            MPI_Comm_free(&inter);
+            printf("[MASTER] lobby: join not confirmed in time, candidate dropped\n");
+            fflush(stdout);
+            continue;
+        }
+        MPI_Comm_disconnect(&inter);
+        return ji.token;
+    }
+}
+
+// star prijem: accept na SELF, auth, pa inter ide u W[] (worker je remote rank 0)
+static void star_admission(const char *PORT, int TARGET, int REQUIRED_MAGIC, MPI_Comm *W)
+{
+    int added = 0;
+    while (added < TARGET)
+    {
+        MPI_Comm inter;
+        double t0 = MPI_Wtime();
+        int rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, MPI_COMM_SELF, &inter);
+        perr("Comm_accept(star)", rc);
+
+        int magic = -1;
+        MPI_Recv(&magic, 1, MPI_INT, 0, TAG_AUTH, inter, MPI_STATUS_IGNORE);
+        int accept_it = (magic == REQUIRED_MAGIC);
+        MPI_Send(&accept_it, 1, MPI_INT, 0, TAG_AUTH_REPLY, inter);
+        if (!accept_it)
+        {
+            MPI_Comm_disconnect(&inter);
+            printf("[MASTER] star: AUTH FAILED, rejecting worker\n");
+            fflush(stdout);
+            continue;
+        }
+
+        int mode = ADMIT_STAR;
+        MPI_Send(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter);
+        W[added++] = inter;
+        printf("[MASTER] star: worker %d admitted in %.3fs\n", added, MPI_Wtime() - t0);
+        fflush(stdout);
+    }
+}
+
+// jedna farma za obe topologije: worker w (1..size-1) je dest_of[w] u comm_of[w] — rank w u CLUSTER-u
+// ili rank 0 u svom inter-u (star). Po jedan Irecv rezultata po workeru, MPI_Waitany.
+static void run_farm(MPI_Comm *comm_of, const int *dest_of, int size, const int *tasks, int NT)
+{
+    int next = 0;
+    int *pairs = calloc(2 * size, sizeof(int));
+    MPI_Request *req = malloc(sizeof(MPI_Request) * (size - 1));
+
+    for (int w = 1; w < size; ++w)
+    {
+        MPI_Irecv(&pairs[2 * w], 2, MPI_INT, dest_of[w], TAG_RESULT, comm_of[w], &req[w - 1]);
+        if (next < NT)
+            MPI_Send((void *)&tasks[next++], 1, MPI_INT, dest_of[w], TAG_TASK, comm_of[w]);
+        else
+            MPI_Send(NULL, 0, MPI_INT, dest_of[w], TAG_IDLE, comm_of[w]);
+    }
+
+    for (;;)
+    {
+        int idx;
+        MPI_Waitany(size - 1, req, &idx, MPI_STATUS_IGNORE);
+        int w = idx + 1;
+        printf("[MASTER] result: %d -> %d (from %d)\n", pairs[2 * w], pairs[2 * w + 1], w);
+        fflush(stdout);
+        MPI_Irecv(&pairs[2 * w], 2, MPI_INT, dest_of[w], TAG_RESULT, comm_of[w], &req[idx]);
+        if (next < NT)
+            MPI_Send((void *)&tasks[next++], 1, MPI_INT, dest_of[w], TAG_TASK, comm_of[w]);
+        else
+            MPI_Send(NULL, 0, MPI_INT, dest_of[w], TAG_IDLE, comm_of[w]);
+    }
+}
+
+// port režim: kolektivne admission runde nad CLUSTER-om koji raste posle svakog merge-a.
+// LOBBY != 0: kandidat je već prošao auth u lobby-ju na LPORT, ovde se proverava samo token.
+static MPI_Comm port_admission(const char *PORT, const char *LPORT, int LOBBY, int TARGET, int REQUIRED_MAGIC,
+                               double timeout_s)
+{
+    // CLUSTER = COMM_SELF (posle svakog merge-a raste)
+    MPI_Comm CLUSTER;
+    int rc = MPI_Comm_dup(MPI_COMM_SELF, &CLUSTER);
+    perr("Comm_dup(self)", rc);
+
+    int added = 0;
+int accept_it=1;
+    // Admission runde: isti kod za prvi i sve sledeće talase
+    while (added < TARGET)
+    {
+  printf( "%d\n",added);
+          fflush(stdout);
+        // lobby: čekamo verifikovanog kandidata pre nego što iko iz CLUSTER-a uđe u rundu
+        int token = 0;
+        if (LOBBY)
+            token = lobby_admit(LPORT, PORT, REQUIRED_MAGIC, timeout_s);
+        // poravnanje runde sa trenutnim CLUSTER-om
+         if (accept_it){
+        MPI_Barrier(CLUSTER);
+
+        // najavi da primamo još (more=1) i podeli port
+      
+         }  bcast_more_and_port(CLUSTER, /*more=*/1, PORT);
+        // kolektivni accept preko CLUSTER-a (prvi put učestvuje samo master)
+        MPI_Comm inter;
+printf("Pre ACCEPT");
+            fflush(stdout);
+        rc = MPI_Comm_accept(PORT, MPI_INFO_NULL, 0, CLUSTER, &inter);
+        perr("Comm_accept", rc);
+        printf("posle ACCEPT");
+            fflush(stdout);
+             accept_it = 0;
+            if (LOBBY)
+            {
+                // auth je već prošao u lobby-ju; ovde se samo proverava token
+                int t = 0;
+                recv_timeout(&t, 1, MPI_INT, 0, TAG_JOIN_TOKEN, inter, timeout_s);
+                accept_it = (t == token);
+            }
+            else
+            {
+                int magic = -1;
+                MPI_Recv(&magic, 1, MPI_INT, 0, TAG_AUTH, inter, MPI_STATUS_IGNORE);
+                accept_it = (magic == REQUIRED_MAGIC);
+            }
+
+            // 2) pošalji reply novom (AUTH_REPLY)
+            MPI_Send(&accept_it, 1, MPI_INT, 0, TAG_AUTH_REPLY, inter);
+
+            // 3) OBAVEZNO: broadcast odluke SVIM članovima CLUSTER-a u OVOJ RUNDI
+          MPI_Bcast(&accept_it, 1, MPI_INT, 0, CLUSTER);
+
+            if (!accept_it)
+            {
+                // 4a) svi lokalni (master + stari workeri) rade DISCONNECT nad istim inter
+                MPI_Comm_disconnect(&inter);
+  
+                // 5) poravnanje kraja runde
+                MPI_Barrier(CLUSTER);
+                  printf("Prosao bcast barijeru");
+            fflush(stdout);
+                continue; // bez merge-a u ovoj rundi
+            }
+        else{
+    printf("usao u");
+            fflush(stdout);
+        int mode = ADMIT_COLLECTIVE;
+        MPI_Send(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter);
+        // NEMA barijere na "inter" — merge je već kolektivan
+        MPI_Comm CL_NEW;
+        rc = MPI_Intercomm_merge(inter, /*high master*/ 0, &CL_NEW);
+        perr("Intercomm_merge", rc);
+        MPI_Comm_disconnect(&inter);
+
+        // zameni CLUSTER i javi novu veličinu
+        MPI_Comm_free(&CLUSTER);
+        CLUSTER = CL_NEW;
+        int s;
+        MPI_Comm_size(CLUSTER, &s);
+        printf("[MASTER] merged wave -> size=%d (workers=%d)\n", s, s - 1);
+        fflush(stdout);
+        added++;}
+    }
+    printf("USAAOOOOO");
+    fflush(stdout);
+    // (opciono) zatvori port da kasniji connect ne visi
+    MPI_Barrier(CLUSTER);
+    bcast_more_and_port(CLUSTER, /*more=*/0, /*port=*/NULL);
+
+    return CLUSTER;
+}
+
+int main(int argc, char **argv)
+{
+    MPI_Init(&argc, &argv);
+    srand((unsigned)time(NULL));
+    const int REQUIRED_MAGIC = 5;
+    const int TARGET = getenv_int("TARGET_WORKERS", 1);
+
+    const char *adm = getenv("ADMISSION");
+    const int STAR = adm && !strcmp(adm, "star");
+    // LOBBY=1: u port.txt ide lobby port; join port znaju samo kandidati koji su prošli auth.
+    // Star prijem je već samo na SELF, pa tamo lobby nema smisla.
+    const int LOBBY = !STAR && getenv_int("LOBBY", 0);
+    const double timeout_s = getenv_int("AUTH_TIMEOUT_MS", 2000) / 1000.0;
+
+    // 1) Otvori port(ove) i objavi javni (stdout + port.txt)
+    char PORT[MPI_MAX_PORT_NAME];
+    char LPORT[MPI_MAX_PORT_NAME];
+    int rc = MPI_Open_port(MPI_INFO_NULL, PORT);
+    perr("Open_port", rc);
+    if (rc != MPI_SUCCESS)
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    if (LOBBY)
+    {
+        rc = MPI_Open_port(MPI_INFO_NULL, LPORT);
+        perr("Open_port(lobby)", rc);
+        if (rc != MPI_SUCCESS)
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    const char *PUBLIC = LOBBY ? LPORT : PORT;
+    printf("%s\n", PUBLIC);
+    fflush(stdout);
+    {
+        FILE *f = fopen("port.txt", "w");
+        if (f)
+        {
+            fprintf(f, "%s\n", PUBLIC);
+            fclose(f);
+        }
+    }
+
+    // 2) star: po jedan inter po workeru; inače CLUSTER = COMM_SELF koji raste kroz admission runde
+    MPI_Comm *W = NULL;
+    MPI_Comm CLUSTER = MPI_COMM_NULL;
+    if (STAR)
+    {
+        W = malloc(sizeof(MPI_Comm) * TARGET);
+        star_admission(PORT, TARGET, REQUIRED_MAGIC, W);
+    }
+    else
+        CLUSTER = port_admission(PORT, LPORT, LOBBY, TARGET, REQUIRED_MAGIC, timeout_s);
+    MPI_Close_port(PORT);
+    if (LOBBY)
+        MPI_Close_port(LPORT);
+
+    // 3) Demo task-farm, ista petlja za obe topologije (kao u masterTLS.c)
+    int tasks[] = {2, 3, 4, 5, 6, 7, 8, 9, 10};
+    int NT = (int)(sizeof(tasks) / sizeof(tasks[0]));
+
+    // worker w (1..size-1) je dest_of[w] u comm_of[w]: rank w u CLUSTER-u, ili rank 0 u W[w-1]
+    int size;
+    if (STAR)
+        size = TARGET + 1;
+    else
+        MPI_Comm_size(CLUSTER, &size);
+    MPI_Comm *comm_of = malloc(sizeof(MPI_Comm) * size);
+    int *dest_of = malloc(sizeof(int) * size);
+    for (int w = 1; w < size; ++w)
+    {
+        comm_of[w] = STAR ? W[w - 1] : CLUSTER;
+        dest_of[w] = STAR ? 0 : w;
+    }
+    if (size > 1)
+        run_farm(comm_of, dest_of, size, tasks, NT);
+
+    free(dest_of);
+    free(comm_of);
+    if (STAR)
+    {
+        for (int i = 0; i < TARGET; ++i)
+            MPI_Comm_disconnect(&W[i]);
+        free(W);
+        MPI_Finalize();
+        return 0;
+    }
+    MPI_Comm_free(&CLUSTER);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,72 @@
+// probe_transport.c — ping-pong između ranga 0 i 1 za veličine poruka koje farma zaista šalje
+// Pokreće ga tune_transport.sh jednom po kombinaciji pml/btl/interfejsa (MCA se bira pri MPI_Init).
+// Build: mpicc -O2 -std=gnu11 -o probe_transport probe_transport.c
+// Run:   mpirun -np 2 [--host a,b] [--mca ...] ./probe_transport [bajtova ...]
+//
+// Izlaz (rank 0): po liniji "size=<B> lat_us=<jednosmerno> bw_MBps=<...>" i na kraju
+// "COST <us>" = zbir jednosmernih vremena za sve veličine (jedna poruka svake veličine).
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 4 = TASK sa jednim int-om, 8 = RESULT par, 4096 = chunk od 1024 int-a (SCHED_MAX_CHUNK),
+// 65536 = veći batch; za njega je COMPRESS_MIN_BYTES odavno pređen
+static const int DEFAULT_SIZES[] = {4, 8, 256, 4096, 65536};
+
+static double pingpong(char* buf, int bytes, int iters, int rank){
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0=MPI_Wtime();
+  for (int i=0;i<iters;++i){
+    if (rank==0){
+      MPI_Send(buf,bytes,MPI_BYTE,1,0,MPI_COMM_WORLD);
+      MPI_Recv(buf,bytes,MPI_BYTE,1,0,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+    } else {
+      MPI_Recv(buf,bytes,MPI_BYTE,0,0,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+      MPI_Send(buf,bytes,MPI_BYTE,0,0,MPI_COMM_WORLD);
+    }
+  }
+  return (MPI_Wtime()-t0)/(2.0*iters);   // jednosmerno
+}
+
+int main(int argc, char** argv){
+  MPI_Init(&argc,&argv);
+  int rank, size; MPI_Comm_rank(MPI_COMM_WORLD,&rank); MPI_Comm_size(MPI_COMM_WORLD,&size);
+  if (size!=2){
+    if (rank==0) fprintf(stderr,"usage: mpirun -np 2 %s [bytes ...]\n", argv[0]);
+    MPI_Abort(MPI_COMM_WORLD,1);
+  }
+
+  int n = argc>1 ? argc-1 : (int)(sizeof DEFAULT_SIZES/sizeof DEFAULT_SIZES[0]);
+  int* sizes=malloc(sizeof(int)*n); int maxb=1;
+  for (int i=0;i<n;++i){
+    sizes[i] = argc>1 ? atoi(argv[i+1]) : DEFAULT_SIZES[i];
+    if (sizes[i]<1) sizes[i]=1;
+    if (sizes[i]>maxb) maxb=sizes[i];
+  }
+  char* buf=malloc(maxb); memset(buf,0x5a,maxb);
+
+  if (rank==0){
+    char name[MPI_MAX_PROCESSOR_NAME]; int len=0; MPI_Get_processor_name(name,&len);
+    printf("# probe from %s\n", name);
+  }
+
+  double cost=0;
+  for (int i=0;i<n;++i){
+    int b=sizes[i];
+    // ~32 MB saobraćaja po veličini, ali bar 20 i najviše 2000 iteracija
+    int iters = (32<<20)/b; if (iters<20) iters=20; if (iters>2000) iters=2000;
+    pingpong(buf,b,iters/10+1,rank);               // zagrevanje (konekcije, registracija)
+    double t=pingpong(buf,b,iters,rank);
+    if (rank==0){
+      printf("size=%d lat_us=%.2f bw_MBps=%.1f\n", b, t*1e6, b/t/1e6);
+      fflush(stdout);
+    }
+    cost+=t*1e6;
+  }
+  if (rank==0) printf("COST %.3f\n", cost);
+
+  free(buf); free(sizes);
+  MPI_Finalize();
+  return 0;
+}
@@ -1,50 +1,97 @@
-#!/usr/bin/env bash
-# Start MASTER bez tee (master sam piše port.txt)
-# Usage:
-#   TARGET_WORKERS=3 ./start_master.sh
-#   IFACE=lo TARGET_WORKERS=3 ./start_master.sh   # lokalno na loopback
-
-set -euo pipefail
-
-APP_DIR="${APP_DIR:-$(pwd)}"
-URI_FILE="${URI_FILE:-$APP_DIR/ompi-uri.txt}"
-MASTER_BIN="${MASTER_BIN:-$APP_DIR/master}"
-MASTER_SRC="${MASTER_SRC:-$APP_DIR/master.c}"
-TARGET_WORKERS="${TARGET_WORKERS:-3}"
-IFACE="${IFACE:-}"   # npr. lo, eth0, wg0
-
-echo "[master] app dir: $APP_DIR"
-echo "[master] target workers: $TARGET_WORKERS"
-
-command -v mpirun >/dev/null || { echo "mpirun not found"; exit 1; }
-command -v ompi-server >/dev/null || { echo "ompi-server not found"; exit 1; }
-
-# pokreni ompi-server ako već ne radi
-if ! pgrep -f "ompi-server" >/dev/null 2>&1; then
-  echo "[master] starting ompi-server…"
-  ompi-server --no-daemonize --report-uri "$URI_FILE" >/dev/null 2>&1 &
-  sleep 1
-fi
-
-[[ -s "$URI_FILE" ]] || { echo "ERROR: $URI_FILE missing/empty"; exit 1; }
-URI="$(cat "$URI_FILE")"
-echo "[master] pmix URI: $URI"
-
-# build ako treba
-if [[ -f "$MASTER_SRC" ]] && { [[ ! -x "$MASTER_BIN" ]] || [[ "$MASTER_SRC" -nt "$MASTER_BIN" ]]; }; then
-  echo "[master] building: $MASTER_SRC -> $MASTER_BIN"
-  mpicc -O2 -std=gnu11 -o "$MASTER_BIN" "$MASTER_SRC"
-fi
-
-# MCA flagovi
-MCA=( --mca pmix_server_uri "$URI" )
-if [[ -n "$IFACE" ]]; then
-  MCA+=( --mca pmix_tcp_if_include "$IFACE"
-        --mca pml ob1 --mca btl tcp,self --mca oob tcp
-        --mca btl_tcp_if_include "$IFACE" --mca oob_tcp_if_include "$IFACE" )
-fi
-
-echo "[master] starting…"
-export TARGET_WORKERS
-set -x
-mpirun "${MCA[@]}" -np 1 "$MASTER_BIN"
+#!/usr/bin/env bash
+# Start MASTER bez tee (master sam piše port.txt)
+# Usage:
+#   TARGET_WORKERS=3 ./start_master.sh
+#   IFACE=lo TARGET_WORKERS=3 ./start_master.sh   # lokalno na loopback
+#   SPAWN_WORKERS=3 ./start_master.sh             # master sam spawn-uje workere (bez ompi-server/port.txt)
+#   SPAWN_HOSTFILE=hosts.txt ./start_master.sh    # spawn po hostfile-u ("host slots=N")
+#   MASTER_SRC=masterTLS.c ADMISSION=star ./start_master.sh   # prijem samo na masteru, bez kolektivnih rundi
+#   MASTER_SRC=masterTLS.c SPAWN_WORKERS=3 ./start_master.sh   # spawn sa handshakom; worker je workerTLS.c (WORKER_SRC menja)
+#   MASTER_SRC=master_with_auth.c LOBBY=1 ./start_master.sh    # auth u lobby-ju (port.txt = lobby port), AUTH_TIMEOUT_MS rok
+#   MASTER_SRC=masterTLS.c TICKET_TTL_S=600 TICKET_REVOKE_FILE=revoked.txt ./start_master.sh   # resumption ticketi
+#   METRICS_FILE=/var/lib/node_exporter/farm.prom ./start_master.sh   # Prometheus metrike (METRICS_INTERVAL_MS)
+#   SPEC_FACTOR=4 SPEC_MIN_MS=50 ./start_master.sh   # spekulativne kopije chunk-ova koji kasne na repu posla, bar SPEC_MIN_MS (SPEC=0 isključuje)
+#   ORDERED=1 REORDER_WINDOW=4096 ./start_master.sh   # rezultati po redosledu taskova, ograničen bafer
+#   SCHED=guided SCHED_MAX_CHUNK=1048576 ./start_master.sh   # veliki chunk-ovi (>= STREAM_MIN_BYTES) u delovima, preklopljeno sa računanjem (STREAM=0 isključuje)
+#   STREAM_MIN_BYTES=1048576 STREAM_PIECE_BYTES=262144 ./start_master.sh   # prag i deo (ovo su default-i); uz COMPRESS=1 chunk ide kroz LZ, ne u delovima
+#   RELEASE_FILE=release.txt ./start_master.sh   # "echo 2 > release.txt" otpušta 2 workera usred posla; SCALE_IN_KEEP=N kad se red isprazni
+#   SPOOL_DIR=spool ./start_master.sh   # više poslova: <ime>.job -> <ime>.out, weighted fair share (weight=W u fajlu), SPOOL_POLL_MS
+#   RESULTS_FILE=/shared/res.bin SCHED=guided ./start_master.sh   # workeri pišu int32 rezultate MPI-IO-om (task i na bajtu i*4), master prima samo potvrde (SCHED=single se tada menja u guided)
+#   INPUT_FILE=/shared/in.bin RESULTS_FILE=/shared/res.bin ./start_master.sh   # master šalje samo {offset, len}, workeri sami čitaju int32 ulaze
+
+set -euo pipefail
+
+APP_DIR="${APP_DIR:-$(pwd)}"
+URI_FILE="${URI_FILE:-$APP_DIR/ompi-uri.txt}"
+MASTER_BIN="${MASTER_BIN:-$APP_DIR/master}"
+MASTER_SRC="${MASTER_SRC:-$APP_DIR/master.c}"
+TARGET_WORKERS="${TARGET_WORKERS:-3}"
+IFACE="${IFACE:-}"   # npr. lo, eth0, wg0
+MCA_PROFILE="${MCA_PROFILE:-$APP_DIR/mca-tuned.conf}"   # ./tune_transport.sh
+SPAWN_WORKERS="${SPAWN_WORKERS:-}"
+SPAWN_HOSTFILE="${SPAWN_HOSTFILE:-}"
+# spawn: deca moraju da govore protokol mastera (TLS master → workerTLS.c, sa svojim binarnim fajlom)
+case "$(basename "$MASTER_SRC")" in
+  *TLS*) WORKER_DEF=workerTLS ;;
+  *)     WORKER_DEF=worker ;;
+esac
+WORKER_BIN="${WORKER_BIN:-$APP_DIR/$WORKER_DEF}"
+WORKER_SRC="${WORKER_SRC:-$APP_DIR/$WORKER_DEF.c}"
+
+echo "[master] app dir: $APP_DIR"
+
+command -v mpirun >/dev/null || { echo "mpirun not found"; exit 1; }
+
+MCA=()
+if [[ -n "$SPAWN_WORKERS" || -n "$SPAWN_HOSTFILE" ]]; then
+  # spawn režim: nema ompi-server-a ni port.txt, workere pravi master
+  echo "[master] spawn mode: workers=${SPAWN_WORKERS:-hostfile} hostfile=${SPAWN_HOSTFILE:-none}"
+  if [[ -f "$WORKER_SRC" ]] && { [[ ! -x "$WORKER_BIN" ]] || [[ "$WORKER_SRC" -nt "$WORKER_BIN" ]]; }; then
+    echo "[master] building: $WORKER_SRC -> $WORKER_BIN"
+    WLIBS=()
+    [[ "$WORKER_SRC" == *TLS* ]] && WLIBS+=( -lsodium )   # resumption binder (crypto_secretbox)
+    mpicc -O2 -std=gnu11 -o "$WORKER_BIN" "$WORKER_SRC" "${WLIBS[@]}"
+  fi
+  [[ -n "$SPAWN_HOSTFILE" ]] && MCA+=( --hostfile "$SPAWN_HOSTFILE" )
+else
+  echo "[master] target workers: $TARGET_WORKERS"
+  command -v ompi-server >/dev/null || { echo "ompi-server not found"; exit 1; }
+
+  # pokreni ompi-server ako već ne radi
+  if ! pgrep -f "ompi-server" >/dev/null 2>&1; then
+    echo "[master] starting ompi-server…"
+    ompi-server --no-daemonize --report-uri "$URI_FILE" >/dev/null 2>&1 &
+    sleep 1
+  fi
+
+  [[ -s "$URI_FILE" ]] || { echo "ERROR: $URI_FILE missing/empty"; exit 1; }
+  URI="$(cat "$URI_FILE")"
+  echo "[master] pmix URI: $URI"
+  MCA+=( --mca pmix_server_uri "$URI" )
+fi
+
+# build ako treba
+if [[ -f "$MASTER_SRC" ]] && { [[ ! -x "$MASTER_BIN" ]] || [[ "$MASTER_SRC" -nt "$MASTER_BIN" ]]; }; then
+  echo "[master] building: $MASTER_SRC -> $MASTER_BIN"
+  LIBS=()
+  [[ "$MASTER_SRC" == *TLS* ]] && LIBS+=( -lsodium )   # resumption ticketi (crypto_secretbox)
+  mpicc -O2 -std=gnu11 -pthread -o "$MASTER_BIN" "$MASTER_SRC" "${LIBS[@]}"   # -pthread: metrics.h
+fi
+
+# MCA flagovi: profil iz tune_transport.sh ako postoji, inače ručni IFACE izbor
+[[ -n "$IFACE" ]] && MCA+=( --mca pmix_tcp_if_include "$IFACE" )
+if [[ -s "$MCA_PROFILE" ]]; then
+  echo "[master] MCA profile: $MCA_PROFILE"
+  while read -r k _ v; do
+    [[ -z "$k" || "$k" == \#* ]] && continue
+    MCA+=( --mca "$k" "${v%$'\r'}" )
+  done < "$MCA_PROFILE"
+elif [[ -n "$IFACE" ]]; then
+  MCA+=( --mca pml ob1 --mca btl tcp,self --mca oob tcp
+        --mca btl_tcp_if_include "$IFACE" --mca oob_tcp_if_include "$IFACE" )
+fi
+
+echo "[master] starting…"
+export TARGET_WORKERS SPAWN_WORKERS SPAWN_HOSTFILE WORKER_BIN
+set -x
+mpirun "${MCA[@]}" -np 1 "$MASTER_BIN"
@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+# Jednom po deployment-u: probe_transport za svaku pml/btl/interfejs kombinaciju,
+# najjeftinija ide u MCA profil koji start_master.sh i start_wokrer.sh učitavaju.
+# Usage:
+#   ./tune_transport.sh                              # oba ranga na ovom hostu
+#   PROBE_HOSTS=node1,node2 ./tune_transport.sh      # host mastera + host workera
+#   PROBE_HOSTS=node1,node2 PROBE_IFACES="eth0 ib0" PROBE_SIZES="4 8 4096" ./tune_transport.sh
+#   PROBE_MARGIN=10 ./tune_transport.sh              # kandidat mora biti bar 10% jeftiniji od baseline-a
+#   MPIRUN_EXTRA=--oversubscribe ./tune_transport.sh
+
+set -euo pipefail
+
+APP_DIR="${APP_DIR:-$(pwd)}"
+PROBE_BIN="${PROBE_BIN:-$APP_DIR/probe_transport}"
+PROBE_SRC="${PROBE_SRC:-$APP_DIR/probe_transport.c}"
+MCA_PROFILE="${MCA_PROFILE:-$APP_DIR/mca-tuned.conf}"
+PROBE_HOSTS="${PROBE_HOSTS:-}"
+PROBE_SIZES="${PROBE_SIZES:-}"       # prazno = veličine iz farme (vidi probe_transport.c)
+PROBE_IFACES="${PROBE_IFACES:-$(ls /sys/class/net 2>/dev/null | tr '\n' ' ')}"
+PROBE_TIMEOUT="${PROBE_TIMEOUT:-60}"
+PROBE_MARGIN="${PROBE_MARGIN:-5}"    # % za koji kandidat mora da pobedi trenutno najbolji (šum merenja)
+MPIRUN_EXTRA="${MPIRUN_EXTRA:-}"     # npr. --oversubscribe na hostu sa jednim jezgrom
+
+command -v mpirun >/dev/null || { echo "mpirun not found"; exit 1; }
+
+# build ako treba
+if [[ -f "$PROBE_SRC" ]] && { [[ ! -x "$PROBE_BIN" ]] || [[ "$PROBE_SRC" -nt "$PROBE_BIN" ]]; }; then
+  echo "[tune] building: $PROBE_SRC -> $PROBE_BIN"
+  mpicc -O2 -std=gnu11 -o "$PROBE_BIN" "$PROBE_SRC"
+fi
+
+HOSTS=()
+[[ -n "$PROBE_HOSTS" ]] && HOSTS+=( --host "$PROBE_HOSTS" )
+# shellcheck disable=SC2206
+HOSTS+=( $MPIRUN_EXTRA )
+
+# lo i virtuelni interfejsi (bridge, veth, ifb, tun...) nikad ne nose saobraćaj između hostova;
+# bond/team su virtuelni u sysfs-u ali jesu prava veza
+is_virtual() {
+  case "$1" in
+    lo|docker*|veth*|br-*|virbr*|ifb*|tun*|tap*|dummy*|cni*|flannel*|cali*|vxlan*|kube*) return 0 ;;
+    bond*|team*) return 1 ;;
+  esac
+  [[ "$(readlink -f "/sys/class/net/$1" 2>/dev/null)" == */devices/virtual/* ]]
+}
+
+# kandidati: "ključ=vrednost ..." (vader radi samo unutar hosta, tcp ostaje rezerva);
+# prvi je baseline bez ograničenja interfejsa
+CANDS=( "pml=ob1 btl=self,vader,tcp" )
+# izbor interfejsa ima smisla samo kad probe zaista ide preko mreže (dva različita hosta)
+NHOSTS="$(tr ',' '\n' <<<"$PROBE_HOSTS" | sed 's/:.*//' | sed '/^$/d' | sort -u | wc -l)"
+if (( NHOSTS >= 2 )); then
+  for ifc in $PROBE_IFACES; do
+    if is_virtual "$ifc"; then echo "[tune] $ifc: virtual, skipped"; continue; fi
+    CANDS+=( "pml=ob1 btl=self,vader,tcp btl_tcp_if_include=$ifc oob_tcp_if_include=$ifc" )
+  done
+else
+  echo "[tune] single host: interface candidates skipped (set PROBE_HOSTS=hostA,hostB)"
+fi
+ompi_info 2>/dev/null | grep -q "MCA pml: ucx" && CANDS+=( "pml=ucx" )
+
+BEST=""; BEST_COST=""
+for c in "${CANDS[@]}"; do
+  ARGS=()
+  for kv in $c; do ARGS+=( --mca "${kv%%=*}" "${kv#*=}" ); done
+  # shellcheck disable=SC2086
+  if ! OUT="$(timeout "$PROBE_TIMEOUT" mpirun "${ARGS[@]}" "${HOSTS[@]}" -np 2 "$PROBE_BIN" $PROBE_SIZES 2>/dev/null)"; then
+    echo "[tune] $c: failed"
+    continue
+  fi
+  COST="$(awk '/^COST/{print $2}' <<<"$OUT")"
+  [[ -n "$COST" ]] || { echo "[tune] $c: no result"; continue; }
+  echo "[tune] $c: cost=${COST}us"
+  grep '^size=' <<<"$OUT" | sed 's/^/         /'
+  # baseline (prvi koji radi) ostaje osim ako ga kandidat pobedi za više od PROBE_MARGIN %
+  if [[ -z "$BEST" ]] || awk -v a="$COST" -v b="$BEST_COST" -v m="$PROBE_MARGIN" 'BEGIN{exit !(a < b*(1-m/100))}'; then
+    BEST="$c"; BEST_COST="$COST"
+  fi
+done
+
+[[ -n "$BEST" ]] || { echo "ERROR: no transport combination worked"; exit 1; }
+
+# Open MPI format param fajla ("ime = vrednost"); skripte ga pretvaraju u --mca parove
+{
+  echo "# tune_transport.sh $(date -Is) hosts=${PROBE_HOSTS:-local} cost_us=$BEST_COST"
+  for kv in $BEST; do echo "${kv%%=*} = ${kv#*=}"; done
+} > "$MCA_PROFILE"
+echo "[tune] best: $BEST (cost=${BEST_COST}us) -> $MCA_PROFILE"
@@ -1,80 +1,342 @@
-// worker.c — inicijalni HELLO/MERGE sa masterom, zatim KOLEKTIVNI accept dok master ne kaže "more=0"
-// Build: mpicc -O2 -std=gnu11 -o worker worker.c
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-
-enum {
-  TAG_HELLO=1, TAG_MERGE_CMD=2, TAG_READY=3,
-  TAG_TASK=10, TAG_RESULT=11, TAG_IDLE=13
-};
-
-static void perr(const char* where, int rc){
-  if (rc==MPI_SUCCESS) return;
-  char es[256]; int n=0; MPI_Error_string(rc, es, &n);
-  fprintf(stderr,"[WORKER] %s rc=%d (%s)\n", where, rc, es); fflush(stderr);
-}
-
-int main(int argc,char**argv){
-  MPI_Init(&argc,&argv);
-  int wr; MPI_Comm_rank(MPI_COMM_WORLD,&wr);
-  if (argc<2){ if (wr==0) fprintf(stderr,"usage: %s <PORT_STRING>\n", argv[0]); MPI_Abort(MPI_COMM_WORLD,1); }
-  char* PORT = argv[1];
-
-  // --- Prvo spajanje (samo master je s druge strane) ---
-  MPI_Comm inter; int rc = MPI_Comm_connect(PORT, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter); perr("Comm_connect#1", rc);
-  int hello=1; rc = MPI_Send(&hello,1,MPI_INT,0,TAG_HELLO,inter); perr("Send(HELLO#1)", rc);
-  int cmd=0;   rc = MPI_Recv(&cmd,1,MPI_INT,0,TAG_MERGE_CMD,inter,MPI_STATUS_IGNORE); perr("Recv(MERGE_CMD#1)", rc);
-  int ready=1; rc = MPI_Send(&ready,1,MPI_INT,0,TAG_READY,inter); perr("Send(READY#1)", rc);
-  rc = MPI_Barrier(inter); perr("Barrier(inter#1)", rc);
-
-  MPI_Comm CLUSTER; rc = MPI_Intercomm_merge(inter, 1, &CLUSTER); perr("Intercomm_merge#1", rc); // high=1 (novi)
-  MPI_Comm_disconnect(&inter);
-
-  int rank,size; MPI_Comm_rank(CLUSTER,&rank); MPI_Comm_size(CLUSTER,&size);
-  printf("[WORKER] joined CLUSTER: rank=%d of %d (first)\n", rank, size); fflush(stdout);
-
-  // --- KOLEKTIVNI prijemi dok master ne kaže "more=0" ---
-  for(;;){
-    int more=0, len=0; char port[MPI_MAX_PORT_NAME];
-    MPI_Bcast(&more,1,MPI_INT,0,CLUSTER);
-    MPI_Bcast(&len, 1,MPI_INT,0,CLUSTER);
-    if (len>0 && len<=MPI_MAX_PORT_NAME) MPI_Bcast(port,len,MPI_CHAR,0,CLUSTER);
-
-    if (!more) break;
-
-    MPI_Comm inter2;
-    int rc2 = MPI_Comm_accept(port, MPI_INFO_NULL, 0, CLUSTER, &inter2); perr("Comm_accept#next(w)", rc2);
-    rc2 = MPI_Barrier(inter2); perr("Barrier(inter#next,w)", rc2);
-
-    MPI_Comm CL_NEW; rc2 = MPI_Intercomm_merge(inter2, 0, &CL_NEW); perr("Intercomm_merge#next,w", rc2); // high=0 (postojeci)
-    MPI_Comm_disconnect(&inter2);
-
-    MPI_Comm_free(&CLUSTER); CLUSTER = CL_NEW;
-    MPI_Comm_rank(CLUSTER,&rank); MPI_Comm_size(CLUSTER,&size);
-    printf("[WORKER] post-merge: rank=%d of %d\n", rank, size); fflush(stdout);
-  }
-
-  // --- Task-farm petlja ---
-  if (rank != 0){
-    for(;;){
-      MPI_Status st; MPI_Probe(0, MPI_ANY_TAG, CLUSTER, &st);
-      if (st.MPI_TAG==TAG_IDLE){
-        MPI_Recv(NULL,0,MPI_INT,0,TAG_IDLE,CLUSTER,MPI_STATUS_IGNORE);
-        continue;
-      }
-      if (st.MPI_TAG==TAG_TASK){
-        int x=0; MPI_Recv(&x,1,MPI_INT,0,TAG_TASK,CLUSTER,MPI_STATUS_IGNORE);
-        int y=x*x; int pair[2]={x,y};
-        MPI_Send(pair,2,MPI_INT,0,TAG_RESULT,CLUSTER);
-        continue;
-      }
-      // fallback — progutaj nepoznat tag
-      MPI_Recv(NULL,0,MPI_INT,0,st.MPI_TAG,CLUSTER,MPI_STATUS_IGNORE);
-    }
-  }
-
-  MPI_Comm_free(&CLUSTER);
-  MPI_Finalize();
-  return 0;
-}
+// worker.c — inicijalni HELLO/MERGE sa masterom, zatim KOLEKTIVNI accept dok master ne kaže "more=0"
+//            (ako ga je master spawn-ovao: jedan merge sa roditeljem, bez porta i admission rundi)
+// Build: mpicc -O2 -std=gnu11 -o worker worker.c
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compress.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+enum {
+  TAG_HELLO=1, TAG_MERGE_CMD=2, TAG_READY=3,
+  TAG_TASK=10, TAG_RESULT=11, TAG_IDLE=13,
+  TAG_TASK_STREAM=14, TAG_TASK_PIECE=15,
+  TAG_SHRINK=16,                          // scale-in: {keep} pa Comm_split celog CLUSTER-a
+  TAG_TASK_AT=17, TAG_OUTPUT=18, TAG_WRITTEN=19,  // RESULTS_FILE: [start, x...], putanja, potvrda {n}
+  TAG_INPUT=20, TAG_TASK_RANGE=21                 // INPUT_FILE: putanja, {offset, len} u bajtovima
+};
+enum { CAP_STREAM = 0x4 };
+
+static void perr(const char* where, int rc){
+  if (rc==MPI_SUCCESS) return;
+  char es[256]; int n=0; MPI_Error_string(rc, es, &n);
+  fprintf(stderr,"[WORKER] %s rc=%d (%s)\n", where, rc, es); fflush(stderr);
+}
+
+// === BATCH KERNEL: y[i] = x[i]*x[i] nad celim chunk-om ===
+// Varijanta se bira jednom na startu (CPUID preko __builtin_cpu_supports); KERNEL=scalar|avx2|avx512 forsira.
+// Množenje je u unsigned aritmetici (mod 2^32) — isto što daje _mm*_mullo_epi32.
+typedef void (*batch_kernel_fn)(const int* x, int* y, int n);
+
+static void kernel_scalar(const int* x, int* y, int n){
+  for (int i=0;i<n;++i) y[i] = (int)((unsigned)x[i]*(unsigned)x[i]);
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("avx2")))
+static void kernel_avx2(const int* x, int* y, int n){
+  int i=0;
+  for (; i+8<=n; i+=8){
+    __m256i v = _mm256_loadu_si256((const __m256i*)(x+i));
+    _mm256_storeu_si256((__m256i*)(y+i), _mm256_mullo_epi32(v,v));
+  }
+  kernel_scalar(x+i, y+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void kernel_avx512(const int* x, int* y, int n){
+  int i=0;
+  for (; i+16<=n; i+=16){
+    __m512i v = _mm512_loadu_si512((const void*)(x+i));
+    _mm512_storeu_si512((void*)(y+i), _mm512_mullo_epi32(v,v));
+  }
+  if (i<n){  // rep: maskirani load/store umesto skalarne petlje
+    __mmask16 m = (__mmask16)((1u<<(n-i))-1);
+    __m512i v = _mm512_maskz_loadu_epi32(m, x+i);
+    _mm512_mask_storeu_epi32(y+i, m, _mm512_mullo_epi32(v,v));
+  }
+}
+#endif
+
+static batch_kernel_fn select_kernel(const char** name){
+  const char* want=getenv("KERNEL");
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init();
+  int has512 = __builtin_cpu_supports("avx512f"), has2 = __builtin_cpu_supports("avx2");
+  if (want && !strcmp(want,"avx512") && !has512) fprintf(stderr,"[WORKER] KERNEL=avx512 nije podržan, biram automatski\n");
+  if (want && !strcmp(want,"avx2")   && !has2)   fprintf(stderr,"[WORKER] KERNEL=avx2 nije podržan, biram automatski\n");
+  if (!(want && !strcmp(want,"scalar"))){
+    if (has512 && !(want && !strcmp(want,"avx2"))){ *name="avx512"; return kernel_avx512; }
+    if (has2){ *name="avx2"; return kernel_avx2; }
+  }
+#else
+  (void)want;
+#endif
+  *name="scalar"; return kernel_scalar;
+}
+
+// pregovor pri prijemu: master nudi caps + prag, worker prihvata presek sa svojim
+// (COMPRESS=0 gasi LZ, STREAM=0 gasi prijem velikih chunk-ova u delovima)
+static int g_lz = 0, g_lz_min = 4096;
+static int accept_offer(int offer, int min_bytes){
+  const char* c=getenv("COMPRESS"); int mine = (c && !strcmp(c,"0")) ? 0 : CAP_LZ;
+  const char* st=getenv("STREAM"); if (!(st && !strcmp(st,"0"))) mine |= CAP_STREAM;
+  g_lz = (offer & mine & CAP_LZ) != 0; g_lz_min = min_bytes;
+  return offer & mine;
+}
+
+// === RESULTS_FILE: rezultati idu pravo u deljeni fajl (MPI-IO), master dobija samo {n} ===
+// Zapis taska i je int32 y na bajtu i*4; regioni chunk-ova su disjunktni, a spekulativna kopija
+// upisuje iste bajtove na isto mesto, pa zaključavanje ni atomic režim nisu potrebni.
+// INPUT_FILE je isti format za ulaze: master šalje samo {offset, len}, worker čita svoj deo.
+static MPI_File g_out = MPI_FILE_NULL, g_in = MPI_FILE_NULL;
+static char *g_out_path=NULL, *g_in_path=NULL;    // putanje od mastera, za ponovno otvaranje posle SHRINK
+#define OUT_MODE (MPI_MODE_WRONLY|MPI_MODE_CREATE)
+#define IN_MODE  MPI_MODE_RDONLY
+
+// otvaranje je kolektivno: ako ne uspe, master (file_start) i ostali prekidaju isto kao i mi,
+// jer bez fajla nema odakle da se čita / gde da se piše
+static MPI_File file_open(MPI_Comm C, const char* path, int amode){
+  MPI_File fh; int rc = MPI_File_open(C, (char*)path, amode, MPI_INFO_NULL, &fh);
+  if (rc!=MPI_SUCCESS){ fprintf(stderr,"[WORKER] %s: ", path); perr("File_open", rc); MPI_Abort(MPI_COMM_WORLD,1); }
+  return fh;
+}
+
+// kratko čitanje/pisanje (greška, pun disk, ulaz kraći od opsega) ne sme da prođe kao uspeh:
+// master bi dobio potvrdu za rezultate koji nisu u fajlu, odnosno rezultate nad starim ulazom
+static void file_check(const char* where, int rc, MPI_Status* st, int n){
+  int got=0;
+  if (rc==MPI_SUCCESS) MPI_Get_count(st,MPI_INT,&got);
+  if (rc==MPI_SUCCESS && got==n) return;
+  perr(where, rc);
+  fprintf(stderr,"[WORKER] %s: %d od %d int-ova\n", where, got, n); fflush(stderr);
+  MPI_Abort(MPI_COMM_WORLD,1);
+}
+
+// TAG_OUTPUT / TAG_INPUT: putanja od mastera, pa kolektivno otvaranje nad celim CLUSTER-om
+// putanja je poruka proizvoljne dužine: bafer po Get_count-u probe-ovane poruke, uvek sa '\0' na kraju
+static MPI_File file_recv_open(MPI_Message* msg, MPI_Status* st, MPI_Comm C, char** path, int amode){
+  int n=0; MPI_Get_count(st,MPI_CHAR,&n); if (n<0) n=0;
+  free(*path); *path=malloc(n+1);
+  MPI_Mrecv(*path,n,MPI_CHAR,msg,MPI_STATUS_IGNORE);
+  (*path)[n]='\0';
+  return file_open(C, *path, amode);
+}
+
+static void out_write(MPI_Comm C, int start, const int* y, int n){
+  MPI_Status st;
+  int rc = MPI_File_write_at(g_out, (MPI_Offset)start*(MPI_Offset)sizeof(int), y, n, MPI_INT, &st);
+  file_check("File_write_at", rc, &st, n);
+  MPI_Send(&n,1,MPI_INT,0,TAG_WRITTEN,C);
+}
+
+// === VELIKI ULAZI: TAG_TASK_STREAM {n, piece, start}, pa ceil(n/piece) poruka TAG_TASK_PIECE ===
+// Dva prijemna bafera: dok kernel radi nad delom k, deo k+1 već stiže u drugi bafer (Irecv).
+// Kernel ide u blokovima sa MPI_Test između, da bi rendezvous prenos napredovao i bez progress niti.
+// Rezultat celog taska ide jednim MPI_Isend-om iz jednog od dva izlazna bafera, pa sledeći task
+// počinje odmah; bafer se ponovo koristi tek kad je njegovo slanje (od pre dva taska) završeno.
+// Master šalje i sledeći chunk unapred: dok se računa poslednji deo, njegovo zaglavlje se preuzima,
+// a prvi deo stiže u slobodan prijemni bafer (stream_peek), pa prenos ne čeka na povratak rezultata.
+#define STREAM_BLOCK 16384
+typedef struct {
+  int* in[2]; int in_cap[2];
+  int* out[2]; int out_cap[2]; MPI_Request out_req[2]; int cur;
+  int next[3], have_next, nb; MPI_Request nrq;   // preuzeti sledeći chunk: zaglavlje, bafer i prijem prvog dela
+} Stream;
+
+static void stream_init(Stream* S){ memset(S,0,sizeof *S); S->out_req[0]=S->out_req[1]=MPI_REQUEST_NULL; }
+static void stream_free(Stream* S){
+  MPI_Waitall(2,S->out_req,MPI_STATUSES_IGNORE);
+  free(S->in[0]); free(S->in[1]); free(S->out[0]); free(S->out[1]);
+}
+
+static void stream_grow(Stream* S, int b, int piece){
+  if (piece>S->in_cap[b]){ S->in_cap[b]=piece; S->in[b]=realloc(S->in[b],sizeof(int)*piece); }
+}
+
+// tokom poslednjeg dela bafer nb je slobodan: ako je zaglavlje sledećeg chunk-a stiglo, preuzmi ga
+// i odmah postavi prijem njegovog prvog dela (delovi stižu redom, posle svih delova tekućeg)
+static void stream_peek(MPI_Comm C, Stream* S, int nb){
+  if (S->have_next) return;
+  int f=0; MPI_Message msg;
+  MPI_Improbe(0,TAG_TASK_STREAM,C,&f,&msg,MPI_STATUS_IGNORE);
+  if (!f) return;
+  S->next[0]=0; S->next[1]=1; S->next[2]=0;
+  MPI_Mrecv(S->next,3,MPI_INT,&msg,MPI_STATUS_IGNORE);
+  if (S->next[1]<1) S->next[1]=1;
+  stream_grow(S, nb, S->next[1]);
+  MPI_Irecv(S->in[nb],S->next[1],MPI_INT,0,TAG_TASK_PIECE,C,&S->nrq);
+  S->nb=nb; S->have_next=1;
+}
+
+static void stream_task(MPI_Comm C, batch_kernel_fn kernel, int n, int piece, int start, Stream* S){
+  int o=S->cur; S->cur^=1;
+  MPI_Wait(&S->out_req[o],MPI_STATUS_IGNORE);
+  if (n>S->out_cap[o]){ S->out_cap[o]=n; S->out[o]=realloc(S->out[o],sizeof(int)*n); }
+
+  // prvi deo je možda već u prijemu (stream_peek prethodnog taska)
+  int np=(n+piece-1)/piece, b0=0; MPI_Request rq[2];
+  if (S->have_next){ b0=S->nb; rq[b0]=S->nrq; S->have_next=0; }
+  else { stream_grow(S, 0, piece); MPI_Irecv(S->in[0],piece,MPI_INT,0,TAG_TASK_PIECE,C,&rq[0]); }
+  stream_grow(S, b0^1, piece);
+  for (int k=0;k<np;++k){
+    int b=b0^(k&1), nb=b^1, off=k*piece, m = n-off<piece ? n-off : piece;
+    if (k+1<np) MPI_Irecv(S->in[nb],piece,MPI_INT,0,TAG_TASK_PIECE,C,&rq[nb]);
+    MPI_Wait(&rq[b],MPI_STATUS_IGNORE);
+    for (int i=0;i<m;i+=STREAM_BLOCK){
+      kernel(S->in[b]+i, S->out[o]+off+i, m-i<STREAM_BLOCK ? m-i : STREAM_BLOCK);
+      if (k+1<np){ int f; MPI_Test(&rq[nb],&f,MPI_STATUS_IGNORE); }
+      else stream_peek(C, S, nb);
+    }
+  }
+  stream_peek(C, S, b0^((np-1)&1)^1);
+  if (g_out!=MPI_FILE_NULL) out_write(C, start, S->out[o], n);
+  else MPI_Isend(S->out[o],n,MPI_INT,0,TAG_RESULT,C,&S->out_req[o]);
+}
+
+// port režim: connect + HELLO/MERGE, pa kolektivni prijemi dok master ne kaže "more=0"
+static MPI_Comm port_join(char* PORT, int* rank, int* size){
+  MPI_Comm CLUSTER;
+  // --- Prvo spajanje (samo master je s druge strane) ---
+  MPI_Comm inter; int rc = MPI_Comm_connect(PORT, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter); perr("Comm_connect#1", rc);
+  int hello=1; rc = MPI_Send(&hello,1,MPI_INT,0,TAG_HELLO,inter); perr("Send(HELLO#1)", rc);
+  int cmd[3]={0,0,0}; rc = MPI_Recv(cmd,3,MPI_INT,0,TAG_MERGE_CMD,inter,MPI_STATUS_IGNORE); perr("Recv(MERGE_CMD#1)", rc);
+  int ready[2]={1,accept_offer(cmd[1],cmd[2])}; rc = MPI_Send(ready,2,MPI_INT,0,TAG_READY,inter); perr("Send(READY#1)", rc);
+  rc = MPI_Barrier(inter); perr("Barrier(inter#1)", rc);
+
+  rc = MPI_Intercomm_merge(inter, 1, &CLUSTER); perr("Intercomm_merge#1", rc); // high=1 (novi)
+  MPI_Comm_disconnect(&inter);
+
+  MPI_Comm_rank(CLUSTER,rank); MPI_Comm_size(CLUSTER,size);
+  printf("[WORKER] joined CLUSTER: rank=%d of %d (first)\n", *rank, *size); fflush(stdout);
+
+  // --- KOLEKTIVNI prijemi dok master ne kaže "more=0" ---
+  for(;;){
+    int more=0, len=0; char port[MPI_MAX_PORT_NAME];
+    MPI_Bcast(&more,1,MPI_INT,0,CLUSTER);
+    MPI_Bcast(&len, 1,MPI_INT,0,CLUSTER);
+    if (len>0 && len<=MPI_MAX_PORT_NAME) MPI_Bcast(port,len,MPI_CHAR,0,CLUSTER);
+
+    if (!more) break;
+
+    MPI_Comm inter2;
+    int rc2 = MPI_Comm_accept(port, MPI_INFO_NULL, 0, CLUSTER, &inter2); perr("Comm_accept#next(w)", rc2);
+    rc2 = MPI_Barrier(inter2); perr("Barrier(inter#next,w)", rc2);
+
+    MPI_Comm CL_NEW; rc2 = MPI_Intercomm_merge(inter2, 0, &CL_NEW); perr("Intercomm_merge#next,w", rc2); // high=0 (postojeci)
+    MPI_Comm_disconnect(&inter2);
+
+    MPI_Comm_free(&CLUSTER); CLUSTER = CL_NEW;
+    MPI_Comm_rank(CLUSTER,rank); MPI_Comm_size(CLUSTER,size);
+    printf("[WORKER] post-merge: rank=%d of %d\n", *rank, *size); fflush(stdout);
+  }
+
+  return CLUSTER;
+}
+
+int main(int argc,char**argv){
+  MPI_Init(&argc,&argv);
+  int wr; MPI_Comm_rank(MPI_COMM_WORLD,&wr);
+  MPI_Comm parent; MPI_Comm_get_parent(&parent);
+  MPI_Comm CLUSTER; int rank,size;
+
+  if (parent != MPI_COMM_NULL){
+    // --- SPAWN režim: svi spawn-ovani zajedno rade merge sa masterom ---
+    int rc = MPI_Intercomm_merge(parent, 1, &CLUSTER); perr("Intercomm_merge(spawn)", rc); // high=1 (novi)
+    MPI_Comm_disconnect(&parent);
+    int offer[2]={0,0}; MPI_Bcast(offer,2,MPI_INT,0,CLUSTER);
+    int caps=accept_offer(offer[0],offer[1]); MPI_Gather(&caps,1,MPI_INT,NULL,0,MPI_INT,0,CLUSTER);
+    MPI_Comm_rank(CLUSTER,&rank); MPI_Comm_size(CLUSTER,&size);
+    printf("[WORKER] joined CLUSTER: rank=%d of %d (spawned)\n", rank, size); fflush(stdout);
+  } else {
+    if (argc<2){ if (wr==0) fprintf(stderr,"usage: %s <PORT_STRING>\n", argv[0]); MPI_Abort(MPI_COMM_WORLD,1); }
+    CLUSTER = port_join(argv[1], &rank, &size);
+  }
+
+  // --- Task-farm petlja: TAG_TASK nosi chunk od k ulaza, odgovor je k izlaza (isti redosled) ---
+  if (rank != 0){
+    const char* kname; batch_kernel_fn kernel = select_kernel(&kname);
+    printf("[WORKER] rank=%d kernel=%s\n", rank, kname); fflush(stdout);
+    int cap=0; int* xs=NULL; int* ys=NULL;
+    Stream S; stream_init(&S);
+    // veličina chunk-a varira → Mprobe/Mrecv: jedno uparivanje po poruci, bez Probe+Recv para
+    for(;;){
+      MPI_Status st; MPI_Message msg;
+      MPI_Mprobe(0, MPI_ANY_TAG, CLUSTER, &msg, &st);
+      if (st.MPI_TAG==TAG_IDLE){
+        MPI_Mrecv(NULL,0,MPI_INT,&msg,MPI_STATUS_IGNORE);
+        continue;
+      }
+      if (st.MPI_TAG==TAG_SHRINK){
+        // master je primio sve naše rezultate; otpušteni (keep=0) izlaze iz novog komunikatora
+        int keep=0; MPI_Mrecv(&keep,1,MPI_INT,&msg,MPI_STATUS_IGNORE);
+        MPI_Waitall(2,S.out_req,MPI_STATUSES_IGNORE);
+        // kolektivno nad starim CLUSTER-om, istim redom kao master (farm_split)
+        if (g_out!=MPI_FILE_NULL) MPI_File_close(&g_out);
+        if (g_in!=MPI_FILE_NULL) MPI_File_close(&g_in);
+        MPI_Comm NEWC; int rc = MPI_Comm_split(CLUSTER, keep ? 0 : MPI_UNDEFINED, rank, &NEWC); perr("Comm_split(shrink)", rc);
+        MPI_Comm_free(&CLUSTER);   // vidi farm_split u master.c (disconnect merge-ovanog komunikatora zaglavi)
+        if (NEWC==MPI_COMM_NULL){ printf("[WORKER] rank=%d released\n", rank); fflush(stdout); break; }
+        CLUSTER = NEWC; MPI_Comm_size(CLUSTER,&size);
+        if (g_out_path) g_out = file_open(CLUSTER, g_out_path, OUT_MODE);
+        if (g_in_path)  g_in  = file_open(CLUSTER, g_in_path, IN_MODE);
+        printf("[WORKER] rank=%d stays, CLUSTER size=%d\n", rank, size); fflush(stdout);
+        continue;
+      }
+      if (st.MPI_TAG==TAG_TASK_STREAM){
+        int hdr[3]={0,1,0}; MPI_Mrecv(hdr,3,MPI_INT,&msg,MPI_STATUS_IGNORE);
+        stream_task(CLUSTER, kernel, hdr[0], hdr[1]>0 ? hdr[1] : 1, hdr[2], &S);
+        while (S.have_next) stream_task(CLUSTER, kernel, S.next[0], S.next[1], S.next[2], &S);
+        continue;
+      }
+      if (st.MPI_TAG==TAG_OUTPUT){   // master je već obrisao stari fajl
+        g_out = file_recv_open(&msg, &st, CLUSTER, &g_out_path, OUT_MODE);
+        continue;
+      }
+      if (st.MPI_TAG==TAG_INPUT){
+        g_in = file_recv_open(&msg, &st, CLUSTER, &g_in_path, IN_MODE);
+        continue;
+      }
+      if (st.MPI_TAG==TAG_TASK_RANGE){
+        // {offset, len}: ulaz čitamo sami, pa master ne šalje nijedan bajt podataka
+        long long r[2]={0,0}; MPI_Mrecv(r,2,MPI_LONG_LONG,&msg,MPI_STATUS_IGNORE);
+        int k = (int)(r[1]/(long long)sizeof(int));
+        if (k>cap){ cap=k; xs=realloc(xs,sizeof(int)*cap); ys=realloc(ys,sizeof(int)*cap); }
+        MPI_Status rs; int rc = MPI_File_read_at(g_in, (MPI_Offset)r[0], xs, k, MPI_INT, &rs);
+        file_check("File_read_at", rc, &rs, k);
+        kernel(xs, ys, k);
+        if (g_out!=MPI_FILE_NULL) out_write(CLUSTER, (int)(r[0]/(long long)sizeof(int)), ys, k);
+        else lz_send_ints(ys,k,0,TAG_RESULT,CLUSTER,g_lz,g_lz_min);
+        continue;
+      }
+      if ((st.MPI_TAG & ~TAG_LZ)==TAG_TASK_AT){
+        // [start, x...]: isto kao TAG_TASK, ali rezultat ide u RESULTS_FILE
+        int xcap=cap, k=lz_recv_ints(&msg, &st, &xs, &xcap);
+        if (xcap>cap){ cap=xcap; ys=realloc(ys,sizeof(int)*cap); }
+        if (k<1) continue;
+        kernel(xs+1, ys, k-1);
+        out_write(CLUSTER, xs[0], ys, k-1);
+        continue;
+      }
+      if ((st.MPI_TAG & ~TAG_LZ)==TAG_TASK){
+        int xcap=cap, k=lz_recv_ints(&msg, &st, &xs, &xcap);
+        if (k<0) k=0;
+        if (xcap>cap){ cap=xcap; ys=realloc(ys,sizeof(int)*cap); }
+        kernel(xs, ys, k);
+        lz_send_ints(ys,k,0,TAG_RESULT,CLUSTER,g_lz,g_lz_min);
+        continue;
+      }
+      // fallback — progutaj nepoznat tag
+      MPI_Mrecv(NULL,0,MPI_INT,&msg,MPI_STATUS_IGNORE);
+    }
+    stream_free(&S); free(g_out_path); free(g_in_path);
+  }
+
+  if (CLUSTER!=MPI_COMM_NULL) MPI_Comm_free(&CLUSTER);
+  MPI_Finalize();
+  return 0;
+}
@@ -1,247 +1,487 @@
-// worker.c — priključivanje + kolektivne admission runde + task-farm.
-// Build: mpicc -O2 -std=gnu11 -o worker worker.c
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include <sodium.h>
-
-enum {
-    TAG_TASK   = 10,
-    TAG_RESULT = 11,
-    TAG_IDLE   = 13
-};
-
-enum {
-    TAG_AUTH_CLIENT_HELLO = 90,
-    TAG_AUTH_SERVER_HELLO = 91,
-    TAG_AUTH_PROOF        = 92,
-    TAG_AUTH_RESULT       = 93
-};
-
-typedef struct {
-    int worker_id;
-    int nonce_client;
-} AuthClientHello;
-
-typedef struct {
-    int nonce_server;
-} AuthServerHello;
-
-typedef struct {
-    int worker_id;
-    int nonce_client;
-    int nonce_server;
-    int proof;
-} AuthProof;
-
-// session key dobijen iz fake TLS handshaka
-static int g_session_key = 0;
-
-static void perr(const char *where, int rc)
-{
-    if (rc == MPI_SUCCESS)
-        return;
-    char es[256];
-    int n = 0;
-    MPI_Error_string(rc, es, &n);
-    fprintf(stderr, "[WORKER] %s rc=%d (%s)\n", where, rc, es);
-    fflush(stderr);
-}
-
-// “bezbedno” primanje zadatka: XOR sa g_session_key
-static void secure_recv_task(int *x, MPI_Comm comm)
-{
-    int enc = 0;
-    MPI_Recv(&enc, 1, MPI_INT, 0, TAG_TASK, comm, MPI_STATUS_IGNORE);
-    *x = enc ^ g_session_key;
-}
-
-int main(int argc, char **argv)
-{
-    // (opciono) odmah viđi logove
-    setvbuf(stdout, NULL, _IONBF, 0);
-    setvbuf(stderr, NULL, _IONBF, 0);
-
-    MPI_Init(&argc, &argv);
-    srand((unsigned)time(NULL));
-
-    int wr;
-    MPI_Comm_rank(MPI_COMM_WORLD, &wr);
-    if (argc < 2)
-    {
-        if (wr == 0)
-            fprintf(stderr, "usage: %s <PORT_STRING>\n", argv[0]);
-        MPI_Abort(MPI_COMM_WORLD, 1);
-    }
-    char *PORT = argv[1];
-
-    // 1) Prvo spajanje: connect -> fake TLS -> merge(high=1)
-    MPI_Comm inter;
-    int rc = MPI_Comm_connect(PORT, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter);
-    perr("Comm_connect#first", rc);
-
-    // === FAKE "TLS" HANDSHAKE: WORKER STRANA ===
-    AuthClientHello ch;
-    AuthServerHello sh;
-    AuthProof p;
-
-    ch.worker_id    = wr;
-    ch.nonce_client = rand();
-
-    // 1) Pošalji ClientHello masteru
-    rc = MPI_Send(&ch, sizeof(ch), MPI_BYTE, 0, TAG_AUTH_CLIENT_HELLO, inter);
-    perr("Send(AUTH_CLIENT_HELLO)", rc);
-
-    // 2) Primi ServerHello sa server nonce-om
-    rc = MPI_Recv(&sh, sizeof(sh), MPI_BYTE, 0, TAG_AUTH_SERVER_HELLO, inter, MPI_STATUS_IGNORE);
-    perr("Recv(AUTH_SERVER_HELLO)", rc);
-
-    // 3) Izračunaj "proof" (fake, XOR sa tajnom)
-    int SECRET = 0x12345678;   // isti kao u master.c
-
-    p.worker_id    = ch.worker_id;
-    p.nonce_client = ch.nonce_client;
-    p.nonce_server = sh.nonce_server;
-    p.proof        = ch.nonce_client ^ sh.nonce_server ^ SECRET;
-
-    // 4) Pošalji proof masteru
-    rc = MPI_Send(&p, sizeof(p), MPI_BYTE, 0, TAG_AUTH_PROOF, inter);
-    perr("Send(AUTH_PROOF)", rc);
-
-    // 5) Primi rezultat (da li je auth prošao)
-    int accept_it = 0;
-    rc = MPI_Recv(&accept_it, 1, MPI_INT, 0, TAG_AUTH_RESULT, inter, MPI_STATUS_IGNORE);
-    perr("Recv(AUTH_RESULT)", rc);
-
-    if (!accept_it)
-    {
-        printf("[WORKER %d] AUTH FAILED, aborting.\n", wr);
-        fflush(stdout);
-        rc = MPI_Comm_disconnect(&inter);
-        perr("Disconnect(rejected)", rc);
-        MPI_Finalize();
-        return 0;
-    }
-
-    // 6) Izračunaj i zapamti session key
-    int K_session = ch.nonce_client ^ sh.nonce_server ^ SECRET;
-    g_session_key = K_session;
-    printf("[WORKER %d] session key = 0x%x\n", wr, K_session);
-    fflush(stdout);
-
-    // 1b) Merge u CLUSTER
-    MPI_Comm CLUSTER;
-    rc = MPI_Intercomm_merge(inter, /*high=*/1, &CLUSTER);
-    perr("Intercomm_merge#first", rc);
-    MPI_Comm_disconnect(&inter);
-
-    int rank, size;
-    MPI_Comm_rank(CLUSTER, &rank);
-    MPI_Comm_size(CLUSTER, &size);
-    printf("[WORKER %d] joined CLUSTER: size=%d\n", rank, size);
-    MPI_Barrier(CLUSTER);
-
-    // 2) Admission runde
-    for (;;)
-    {
-        printf("pocetak FORA\n");
-        fflush(stdout);
-
-        // primi najavu more,len,port
-        int more = 0, len = 0;
-        char port[MPI_MAX_PORT_NAME];
-        MPI_Bcast(&more, 1, MPI_INT, 0, CLUSTER);
-        MPI_Bcast(&len,  1, MPI_INT, 0, CLUSTER);
-        if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
-            MPI_Bcast(port, len, MPI_CHAR, 0, CLUSTER);
-
-        printf("zavrsio bcast\n");
-        fflush(stdout);
-
-        if (!more)
-        {
-            // kraj admission-a
-            break;
-        }
-
-        // svi “stari” članovi CLUSTER-a ulaze u kolektivni accept
-        MPI_Comm inter2;
-        rc = MPI_Comm_accept(port, MPI_INFO_NULL, 0, CLUSTER, &inter2);
-        perr("Comm_accept#wave", rc);
-
-        {
-            int accept_it_wave = 0;
-            // SVI stari članovi CLUSTER-a moraju da pročitaju odluku koja je bcast-ovana sa mastera
-            MPI_Bcast(&accept_it_wave, 1, MPI_INT, 0, CLUSTER);
-            printf("Prosao bcast\n");
-            fflush(stdout);
-
-            if (!accept_it_wave)
-            {
-                // AUTH odbijen → na istom inter2 svi rade DISCONNECT, bez merge-a
-                MPI_Comm_disconnect(&inter2);
-
-                // kraj runde (poravnanje)
-                MPI_Barrier(CLUSTER);
-                continue; // idemo u sledeću rundu
-            }
-        }
-
-        // NEMA barijere na inter2 — merge je kolektivan
-        MPI_Comm CL_NEW;
-        printf("OVDE SAM\n");
-        fflush(stdout);
-
-        rc = MPI_Intercomm_merge(inter2, /*high (old side)*/ 0, &CL_NEW);
-        perr("Intercomm_merge#wave", rc);
-        MPI_Comm_disconnect(&inter2);
-
-        MPI_Comm_free(&CLUSTER);
-        CLUSTER = CL_NEW;
-
-        MPI_Comm_rank(CLUSTER, &rank);
-        MPI_Comm_size(CLUSTER, &size);
-        printf("[WORKER %d] post-merge CLUSTER size=%d\n", rank, size);
-
-        // poravnanje kraja runde
-        MPI_Barrier(CLUSTER);
-    }
-
-    // 3) Task-farm: svi osim ranga 0 rade
-    MPI_Comm_rank(CLUSTER, &rank);
-    MPI_Comm_size(CLUSTER, &size);
-
-    if (rank != 0)
-    {
-        for (;;)
-        {
-            MPI_Status st;
-            MPI_Probe(0, MPI_ANY_TAG, CLUSTER, &st);
-
-            if (st.MPI_TAG == TAG_IDLE)
-            {
-                MPI_Recv(NULL, 0, MPI_INT, 0, TAG_IDLE, CLUSTER, MPI_STATUS_IGNORE);
-                continue;
-            }
-            if (st.MPI_TAG == TAG_TASK)
-            {
-                int x = 0;
-                // umesto običnog MPI_Recv:
-                secure_recv_task(&x, CLUSTER);
-
-                int y = x * x;
-                int pair[2] = {x, y};
-                MPI_Send(pair, 2, MPI_INT, 0, TAG_RESULT, CLUSTER);
-                continue;
-            }
-            // fallback: progutaj neočekivane tagove
-            MPI_Recv(NULL, 0, MPI_INT, 0, st.MPI_TAG, CLUSTER, MPI_STATUS_IGNORE);
-        }
-    }
-
-    MPI_Comm_free(&CLUSTER);
-    MPI_Finalize();
-    return 0;
-}
+// worker.c — priključivanje + kolektivne admission runde + task-farm.
+// Build: mpicc -O2 -std=gnu11 -o worker workerTLS.c -lsodium
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sodium.h>
+
+enum {
+    TAG_TASK   = 10,
+    TAG_RESULT = 11,
+    TAG_IDLE   = 13
+};
+
+enum {
+    TAG_AUTH_CLIENT_HELLO = 90,
+    TAG_AUTH_SERVER_HELLO = 91,
+    TAG_AUTH_PROOF        = 92,
+    TAG_AUTH_RESULT       = 93,
+    TAG_ADMIT_MODE        = 94,
+    TAG_JOIN_INFO         = 95,
+    TAG_JOIN_TOKEN        = 96,
+    TAG_AUTH_TICKET       = 97,
+    TAG_AUTH_BINDER       = 98,
+    TAG_JOIN_READY        = 99
+};
+
+enum {
+    HELLO_WANT_TICKET = 0x1,
+    HELLO_HAS_TICKET  = 0x2
+};
+
+enum {
+    ADMIT_COLLECTIVE = 0,
+    ADMIT_STAR       = 1,  // nema merge-a: farma ide preko inter-a, master je remote rank 0
+    ADMIT_LOBBY      = 2   // handshake prošao u lobby-ju: reconnect na join port sa tokenom
+};
+
+// ticket je za workera neproziran; TicketBody je tu samo zbog veličine
+typedef struct {
+    int32_t serial;
+    int32_t session_key;
+    int64_t issued;
+    int64_t expires;
+} TicketBody;
+
+typedef struct {
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    unsigned char box[crypto_secretbox_MACBYTES + sizeof(TicketBody)];
+} ResumeTicket;
+
+typedef struct {
+    int worker_id;
+    int nonce_client;
+    int flags;
+    ResumeTicket ticket;
+} AuthClientHello;
+
+typedef struct {
+    int nonce_server;
+    int resumed;
+} AuthServerHello;
+
+// binder = secretbox(nonce_client || nonce_server) ključem iz session key-a ticketa
+typedef struct {
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    unsigned char box[crypto_secretbox_MACBYTES + 2 * sizeof(int)];
+} ResumeBinder;
+
+// TICKET_FILE: ticket + session key sesije u kojoj je izdat (bez ključa ticket ne vredi)
+typedef struct {
+    ResumeTicket ticket;
+    int key;
+} TicketFile;
+
+typedef struct {
+    int worker_id;
+    int nonce_client;
+    int nonce_server;
+    int proof;
+} AuthProof;
+
+typedef struct {
+    int  token;
+    char port[MPI_MAX_PORT_NAME];
+} JoinInfo;
+
+// session key dobijen iz fake TLS handshaka
+static int g_session_key = 0;
+
+static void perr(const char *where, int rc)
+{
+    if (rc == MPI_SUCCESS)
+        return;
+    char es[256];
+    int n = 0;
+    MPI_Error_string(rc, es, &n);
+    fprintf(stderr, "[WORKER] %s rc=%d (%s)\n", where, rc, es);
+    fflush(stderr);
+}
+
+// “bezbedno” primanje zadatka: XOR sa g_session_key (enc je već primljen persistentnim zahtevom)
+static void secure_recv_task(int *x, int enc)
+{
+    *x = enc ^ g_session_key;
+}
+
+static int ticket_load(const char *path, TicketFile *tf)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    int ok = fread(tf, sizeof(*tf), 1, f) == 1;
+    fclose(f);
+    return ok;
+}
+
+// upis preko privremenog fajla + rename, da prekinut upis ne ostavi pola ticketa
+static void ticket_save(const char *path, const TicketFile *tf)
+{
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f)
+    {
+        perror("[WORKER] fopen(TICKET_FILE)");
+        return;
+    }
+    chmod(tmp, 0600);
+    int ok = fwrite(tf, sizeof(*tf), 1, f) == 1;
+    if (fclose(f) == 0 && ok)
+        rename(tmp, path);
+    else
+        remove(tmp);
+}
+
+// === FAKE "TLS" HANDSHAKE: WORKER STRANA ===
+// vraća accept_it; ako je prihvaćen, u *key_out upisuje session key.
+// ticket_file != NULL: ticket iz fajla ide u ClientHello, a novi ticket se upisuje posle uspeha.
+static int client_handshake(MPI_Comm inter, int wr, int *key_out, const char *ticket_file)
+{
+    int rc;
+    AuthClientHello ch;
+    AuthServerHello sh;
+    AuthProof p;
+    TicketFile tf;
+
+    memset(&ch, 0, sizeof(ch));
+    ch.worker_id    = wr;
+    ch.nonce_client = rand();
+    if (ticket_file)
+    {
+        ch.flags |= HELLO_WANT_TICKET;
+        if (ticket_load(ticket_file, &tf))
+        {
+            ch.flags |= HELLO_HAS_TICKET;
+            ch.ticket = tf.ticket;
+        }
+    }
+
+    // 1) Pošalji ClientHello masteru
+    rc = MPI_Send(&ch, sizeof(ch), MPI_BYTE, 0, TAG_AUTH_CLIENT_HELLO, inter);
+    perr("Send(AUTH_CLIENT_HELLO)", rc);
+
+    // 2) Primi ServerHello sa server nonce-om
+    rc = MPI_Recv(&sh, sizeof(sh), MPI_BYTE, 0, TAG_AUTH_SERVER_HELLO, inter, MPI_STATUS_IGNORE);
+    perr("Recv(AUTH_SERVER_HELLO)", rc);
+
+    int accept_it = 1;
+    int K = 0;
+    if (sh.resumed && (ch.flags & HELLO_HAS_TICKET))
+    {
+        // resumed: umesto proof-a binder (dokaz da imamo ključ ticketa), ključ se izvodi iz prethodne sesije
+        ResumeBinder rb;
+        unsigned char key[crypto_secretbox_KEYBYTES];
+        int n[2] = { ch.nonce_client, sh.nonce_server };
+        memset(key, 0, sizeof(key));
+        memcpy(key, &tf.key, sizeof(tf.key));
+        randombytes_buf(rb.nonce, sizeof(rb.nonce));
+        crypto_secretbox_easy(rb.box, (const unsigned char *)n, sizeof(n), rb.nonce, key);
+        rc = MPI_Send(&rb, sizeof(rb), MPI_BYTE, 0, TAG_AUTH_BINDER, inter);
+        perr("Send(AUTH_BINDER)", rc);
+        rc = MPI_Recv(&accept_it, 1, MPI_INT, 0, TAG_AUTH_RESULT, inter, MPI_STATUS_IGNORE);
+        perr("Recv(AUTH_RESULT)", rc);
+
+        K = tf.key ^ ch.nonce_client ^ sh.nonce_server;
+        if (accept_it)
+            printf("[WORKER %d] session resumed from ticket\n", wr);
+    }
+    else
+    {
+        // 3) Izračunaj "proof" (fake, XOR sa tajnom)
+        int SECRET = 0x12345678;   // isti kao u master.c
+
+        p.worker_id    = ch.worker_id;
+        p.nonce_client = ch.nonce_client;
+        p.nonce_server = sh.nonce_server;
+        p.proof        = ch.nonce_client ^ sh.nonce_server ^ SECRET;
+
+        // 4) Pošalji proof masteru
+        rc = MPI_Send(&p, sizeof(p), MPI_BYTE, 0, TAG_AUTH_PROOF, inter);
+        perr("Send(AUTH_PROOF)", rc);
+
+        // 5) Primi rezultat (da li je auth prošao)
+        rc = MPI_Recv(&accept_it, 1, MPI_INT, 0, TAG_AUTH_RESULT, inter, MPI_STATUS_IGNORE);
+        perr("Recv(AUTH_RESULT)", rc);
+        K = ch.nonce_client ^ sh.nonce_server ^ SECRET;
+    }
+
+    *key_out = accept_it ? K : 0;
+    if (accept_it && ticket_file)
+    {
+        rc = MPI_Recv(&tf.ticket, sizeof(tf.ticket), MPI_BYTE, 0, TAG_AUTH_TICKET, inter, MPI_STATUS_IGNORE);
+        perr("Recv(AUTH_TICKET)", rc);
+        tf.key = K;
+        ticket_save(ticket_file, &tf);
+    }
+    return accept_it;
+}
+
+
+// port režim: connect -> fake TLS -> merge, pa kolektivne admission runde.
+// Vraća MPI_COMM_NULL ako je master odbio handshake.
+static MPI_Comm port_join(char *PORT, int wr, int *rank, int *size)
+{
+    // 1) Prvo spajanje: connect -> fake TLS -> merge(high=1)
+    MPI_Comm inter;
+    int rc = MPI_Comm_connect(PORT, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter);
+    perr("Comm_connect#first", rc);
+
+    int K_session = 0;
+    int accept_it = client_handshake(inter, wr, &K_session, getenv("TICKET_FILE"));
+
+    if (!accept_it)
+    {
+        printf("[WORKER %d] AUTH FAILED, aborting.\n", wr);
+        fflush(stdout);
+        rc = MPI_Comm_disconnect(&inter);
+        perr("Disconnect(rejected)", rc);
+        return MPI_COMM_NULL;
+    }
+
+    // 6) Zapamti session key
+    g_session_key = K_session;
+    printf("[WORKER %d] session key = 0x%x\n", wr, K_session);
+    fflush(stdout);
+
+    int mode = ADMIT_COLLECTIVE;
+    rc = MPI_Recv(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter, MPI_STATUS_IGNORE);
+    perr("Recv(ADMIT_MODE)", rc);
+    if (mode == ADMIT_LOBBY)
+    {
+        // lobby: dobijamo join port + token, pa se priključujemo kolektivnoj rundi
+        JoinInfo ji;
+        rc = MPI_Recv(&ji, sizeof(ji), MPI_BYTE, 0, TAG_JOIN_INFO, inter, MPI_STATUS_IGNORE);
+        perr("Recv(JOIN_INFO)", rc);
+        // potvrda da odmah idemo na join port (master bez nje ne pokreće rundu)
+        rc = MPI_Send(&ji.token, 1, MPI_INT, 0, TAG_JOIN_READY, inter);
+        perr("Send(JOIN_READY)", rc);
+        MPI_Comm_disconnect(&inter);
+        ji.port[MPI_MAX_PORT_NAME - 1] = '\0';
+
+        rc = MPI_Comm_connect(ji.port, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter);
+        perr("Comm_connect#join", rc);
+        rc = MPI_Send(&ji.token, 1, MPI_INT, 0, TAG_JOIN_TOKEN, inter);
+        perr("Send(JOIN_TOKEN)", rc);
+        rc = MPI_Recv(&accept_it, 1, MPI_INT, 0, TAG_AUTH_RESULT, inter, MPI_STATUS_IGNORE);
+        perr("Recv(AUTH_RESULT#join)", rc);
+        if (!accept_it)
+        {
+            printf("[WORKER %d] join token rejected, aborting.\n", wr);
+            fflush(stdout);
+            MPI_Comm_disconnect(&inter);
+            return MPI_COMM_NULL;
+        }
+        rc = MPI_Recv(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter, MPI_STATUS_IGNORE);
+        perr("Recv(ADMIT_MODE#join)", rc);
+    }
+    if (mode == ADMIT_STAR)
+    {
+        // star: ostajemo na inter-u, ne učestvujemo u kasnijim prijemima
+        *rank = 1;
+        *size = 2;
+        printf("[WORKER %d] admitted (star)\n", wr);
+        return inter;
+    }
+
+    // 1b) Merge u CLUSTER
+    MPI_Comm CLUSTER;
+    rc = MPI_Intercomm_merge(inter, /*high=*/1, &CLUSTER);
+    perr("Intercomm_merge#first", rc);
+    MPI_Comm_disconnect(&inter);
+
+    MPI_Comm_rank(CLUSTER, rank);
+    MPI_Comm_size(CLUSTER, size);
+    printf("[WORKER %d] joined CLUSTER: size=%d\n", *rank, *size);
+    MPI_Barrier(CLUSTER);
+
+    // 2) Admission runde
+    for (;;)
+    {
+        printf("pocetak FORA\n");
+        fflush(stdout);
+
+        // primi najavu more,len,port
+        int more = 0, len = 0;
+        char port[MPI_MAX_PORT_NAME];
+        MPI_Bcast(&more, 1, MPI_INT, 0, CLUSTER);
+        MPI_Bcast(&len,  1, MPI_INT, 0, CLUSTER);
+        if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
+            MPI_Bcast(port, len, MPI_CHAR, 0, CLUSTER);
+
+        printf("zavrsio bcast\n");
+        fflush(stdout);
+
+        if (!more)
+        {
+            // kraj admission-a
+            break;
+        }
+
+        // svi “stari” članovi CLUSTER-a ulaze u kolektivni accept
+        MPI_Comm inter2;
+        rc = MPI_Comm_accept(port, MPI_INFO_NULL, 0, CLUSTER, &inter2);
+        perr("Comm_accept#wave", rc);
+
+        {
+            int accept_it_wave = 0;
+            // SVI stari članovi CLUSTER-a moraju da pročitaju odluku koja je bcast-ovana sa mastera
+            MPI_Bcast(&accept_it_wave, 1, MPI_INT, 0, CLUSTER);
+            printf("Prosao bcast\n");
+            fflush(stdout);
+
+            if (!accept_it_wave)
+            {
+                // AUTH odbijen → na istom inter2 svi rade DISCONNECT, bez merge-a
+                MPI_Comm_disconnect(&inter2);
+
+                // kraj runde (poravnanje)
+                MPI_Barrier(CLUSTER);
+                continue; // idemo u sledeću rundu
+            }
+        }
+
+        // NEMA barijere na inter2 — merge je kolektivan
+        MPI_Comm CL_NEW;
+        printf("OVDE SAM\n");
+        fflush(stdout);
+
+        rc = MPI_Intercomm_merge(inter2, /*high (old side)*/ 0, &CL_NEW);
+        perr("Intercomm_merge#wave", rc);
+        MPI_Comm_disconnect(&inter2);
+
+        MPI_Comm_free(&CLUSTER);
+        CLUSTER = CL_NEW;
+
+        MPI_Comm_rank(CLUSTER, rank);
+        MPI_Comm_size(CLUSTER, size);
+        printf("[WORKER %d] post-merge CLUSTER size=%d\n", *rank, *size);
+
+        // poravnanje kraja runde
+        MPI_Barrier(CLUSTER);
+    }
+
+    return CLUSTER;
+}
+
+int main(int argc, char **argv)
+{
+    // (opciono) odmah viđi logove
+    setvbuf(stdout, NULL, _IONBF, 0);
+    setvbuf(stderr, NULL, _IONBF, 0);
+
+    MPI_Init(&argc, &argv);
+    srand((unsigned)time(NULL));
+    if (sodium_init() < 0)   // binder za resumption (randombytes + secretbox)
+    {
+        fprintf(stderr, "[WORKER] sodium_init failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int wr;
+    MPI_Comm_rank(MPI_COMM_WORLD, &wr);
+    MPI_Comm parent;
+    MPI_Comm_get_parent(&parent);
+    MPI_Comm CLUSTER;
+    int rank, size, rc;
+
+    if (parent != MPI_COMM_NULL)
+    {
+        // SPAWN režim: master prosleđuje "AUTH"/"NOAUTH" kroz argv
+        int auth = !(argc >= 2 && !strcmp(argv[1], "NOAUTH"));
+        int accept_it = 1;
+        if (auth)
+            accept_it = client_handshake(parent, wr, &g_session_key, NULL);
+        if (!accept_it) {
+            printf("[WORKER %d] AUTH FAILED, aborting.\n", wr);
+            fflush(stdout);
+        }
+
+        // split i merge su kolektivni — odbijeni učestvuju u split-u sa MPI_UNDEFINED
+        MPI_Comm SUB;
+        CLUSTER = MPI_COMM_NULL;
+        rc = MPI_Comm_split(parent, accept_it ? 0 : MPI_UNDEFINED, 0, &SUB);
+        perr("Comm_split(spawn)", rc);
+        if (SUB != MPI_COMM_NULL)
+        {
+            rc = MPI_Intercomm_merge(SUB, /*high=*/1, &CLUSTER);
+            perr("Intercomm_merge(spawn)", rc);
+            MPI_Comm_free(&SUB);
+        }
+        MPI_Comm_disconnect(&parent);
+    }
+    else
+    {
+        if (argc < 2)
+        {
+            if (wr == 0)
+                fprintf(stderr, "usage: %s <PORT_STRING>\n", argv[0]);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        CLUSTER = port_join(argv[1], wr, &rank, &size);
+    }
+
+    if (CLUSTER == MPI_COMM_NULL)
+    {
+        MPI_Finalize();
+        return 0;
+    }
+
+    // 3) Task-farm: svi osim ranga 0 rade (u star režimu CLUSTER je inter, a master remote rank 0)
+    int is_inter = 0;
+    MPI_Comm_test_inter(CLUSTER, &is_inter);
+    if (!is_inter)
+    {
+        MPI_Comm_rank(CLUSTER, &rank);
+        MPI_Comm_size(CLUSTER, &size);
+    }
+
+    if (rank != 0)
+    {
+        // TASK (1 int) i IDLE (0 int) staju u isti bafer → jedan persistentni prijem sa ANY_TAG,
+        // bez MPI_Probe; rezultat je uvek par → persistentno slanje
+        int enc = 0;
+        int pair[2];
+        MPI_Request recv_req, send_req;
+        MPI_Recv_init(&enc, 1, MPI_INT, 0, MPI_ANY_TAG, CLUSTER, &recv_req);
+        MPI_Send_init(pair, 2, MPI_INT, 0, TAG_RESULT, CLUSTER, &send_req);
+
+        for (;;)
+        {
+            MPI_Status st;
+            MPI_Start(&recv_req);
+            MPI_Wait(&recv_req, &st);
+
+            if (st.MPI_TAG == TAG_IDLE)
+                continue;
+            if (st.MPI_TAG == TAG_TASK)
+            {
+                int x = 0;
+                // umesto običnog MPI_Recv:
+                secure_recv_task(&x, enc);
+
+                int y = x * x;
+                pair[0] = x;
+                pair[1] = y;
+                MPI_Start(&send_req);
+                MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+                continue;
+            }
+            // fallback: neočekivani tagovi (do 1 int) su već progutani prijemom
+        }
+
+        MPI_Request_free(&send_req);
+        MPI_Request_free(&recv_req);
+    }
+
+    if (is_inter)
+        MPI_Comm_disconnect(&CLUSTER);
+    else
+        MPI_Comm_free(&CLUSTER);
+    MPI_Finalize();
+    return 0;
+}
@@ -1,178 +1,231 @@
-// worker.c — priključivanje + kolektivne admission runde + task-farm.
-// Build: mpicc -O2 -std=gnu11 -o worker worker.c
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-enum
-{
-    TAG_TASK = 10,
-    TAG_RESULT = 11,
-    TAG_IDLE = 13
-};
-enum
-{
-    TAG_AUTH = 90,
-    TAG_AUTH_REPLY = 91
-};
-static void perr(const char *where, int rc)
-{
-    if (rc == MPI_SUCCESS)
-        return;
-    char es[256];
-    int n = 0;
-    MPI_Error_string(rc, es, &n);
-    fprintf(stderr, "[WORKER] %s rc=%d (%s)\n", where, rc, es);
-    fflush(stderr);
-}
-
-int main(int argc, char **argv)
-{
-    // (opciono) odmah viđi logove
-    setvbuf(stdout, NULL, _IONBF, 0);
-    setvbuf(stderr, NULL, _IONBF, 0);
-
-    MPI_Init(&argc, &argv);
-
-    int wr;
-    MPI_Comm_rank(MPI_COMM_WORLD, &wr);
-    if (argc < 2)
-    {
-        if (wr == 0)
-            fprintf(stderr, "usage: %s <PORT_STRING>\n", argv[0]);
-        MPI_Abort(MPI_COMM_WORLD, 1);
-    }
-    char *PORT = argv[1];
-
-    // 1) Prvo spajanje: connect -> merge(high=1)
-    MPI_Comm inter;
-    int rc = MPI_Comm_connect(PORT, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter);
-
-    perr("Comm_connect#first", rc);
-
-    // Slanje autentikacije
-    int magic =5;
-    rc = MPI_Send(&magic, 1, MPI_INT, 0, TAG_AUTH, inter);
-    perr("Send(AUTH)", rc);
-    int accept_it = 0;
-    rc = MPI_Recv(&accept_it, 1, MPI_INT, 0, TAG_AUTH_REPLY, inter, MPI_STATUS_IGNORE);
-    perr("Recv(AUTH_REPLY)", rc);
-    if (!accept_it)
-    {
-
-        // Master nas je odbio — uredno zatvori i izađi.
-        rc = MPI_Comm_disconnect(&inter);
-        perr("Disconnect(rejected)", rc);
-        MPI_Finalize();
-        return 0;
-    }
-
-    MPI_Comm CLUSTER;
-    rc = MPI_Intercomm_merge(inter, /*high=*/1, &CLUSTER);
-    perr("Intercomm_merge#first", rc);
-    MPI_Comm_disconnect(&inter);
-
-    int rank, size;
-    MPI_Comm_rank(CLUSTER, &rank);
-    MPI_Comm_size(CLUSTER, &size);
-    printf("[WORKER %d] joined CLUSTER: size=%d\n", rank, size);
-    MPI_Barrier(CLUSTER);
-    // 2) Admission runde
-    for (;;)
-    {
-          printf("pocetak FORA");
-            fflush(stdout);
-        // poravnaj rundu sa trenutnim CLUSTER-om
-
-        // primi najavu more,len,port
-        int more = 0, len = 0;
-        char port[MPI_MAX_PORT_NAME];
-        MPI_Bcast(&more, 1, MPI_INT, 0, CLUSTER);
-        MPI_Bcast(&len, 1, MPI_INT, 0, CLUSTER);
-        if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
-            MPI_Bcast(port, len, MPI_CHAR, 0, CLUSTER);
- printf("zavrsio bcast");
-           fflush(stdout);
-        if (more)
-        {
-         //   printf("USAAOOOOO");
-           // fflush(stdout);
-        }
-        else
-        {
-            //printf("BREAAAAAAK");
-            //fflush(stdout);
-            break; // kraj admission-a
-        }
-        // svi “stari” članovi CLUSTER-a ulaze u kolektivni accept
-        MPI_Comm inter2;
-        rc = MPI_Comm_accept(port, MPI_INFO_NULL, 0, CLUSTER, &inter2);
-        perr("Comm_accept#wave", rc);
-        {
-            int accept_it = 0;
-            // SVI stari članovi CLUSTER-a moraju da pročitaju odluku koja je bcast-ovana sa mastera
-            MPI_Bcast(&accept_it, 1, MPI_INT, 0, CLUSTER);
-  printf("Prosao bcast");
-            fflush(stdout);
-            if (!accept_it)
-            {
-                // AUTH odbijen → na istom inter2 svi rade DISCONNECT, bez merge-a
-                MPI_Comm_disconnect(&inter2);
-
-                // kraj runde (poravnanje)
-                MPI_Barrier(CLUSTER);
-                continue; // idemo u sledeću rundu
-            }
-        }
-        // NEMA barijere na interu — merge je kolektivan
-        MPI_Comm CL_NEW;  printf("OVDE SAM");
-            fflush(stdout);
-        rc = MPI_Intercomm_merge(inter2, /*high (old side)*/ 0, &CL_NEW);
-        perr("Intercomm_merge#wave", rc);
-        MPI_Comm_disconnect(&inter2);
-
-        MPI_Comm_free(&CLUSTER);
-        CLUSTER = CL_NEW;
-
-        MPI_Comm_rank(CLUSTER, &rank);
-        MPI_Comm_size(CLUSTER, &size);
-        printf("[WORKER %d] post-merge CLUSTER size=%d\n", rank, size);
-        // poravnanje kraja runde
-        MPI_Barrier(CLUSTER);
-    }
-
-    // 3) Task-farm: svi osim ranga 0 rade
-    MPI_Comm_rank(CLUSTER, &rank);
-    MPI_Comm_size(CLUSTER, &size);
-
-    if (rank != 0)
-    {
-        for (;;)
-        {
-            MPI_Status st;
-            MPI_Probe(0, MPI_ANY_TAG, CLUSTER, &st);
-
-            if (st.MPI_TAG == TAG_IDLE)
-            {
-                MPI_Recv(NULL, 0, MPI_INT, 0, TAG_IDLE, CLUSTER, MPI_STATUS_IGNORE);
-                continue;
-            }
-            if (st.MPI_TAG == TAG_TASK)
-            {
-                int x = 0;
-                MPI_Recv(&x, 1, MPI_INT, 0, TAG_TASK, CLUSTER, MPI_STATUS_IGNORE);
-                int y = x * x;
-                int pair[2] = {x, y};
-                MPI_Send(pair, 2, MPI_INT, 0, TAG_RESULT, CLUSTER);
-                continue;
-            }
-            // fallback: progutaj neočekivane tagove
-            MPI_Recv(NULL, 0, MPI_INT, 0, st.MPI_TAG, CLUSTER, MPI_STATUS_IGNORE);
-        }
-    }
-
-    MPI_Comm_free(&CLUSTER);
-    MPI_Finalize();
-    return 0;
-}
+// worker.c — priključivanje + kolektivne admission runde + task-farm.
+// Build: mpicc -O2 -std=gnu11 -o worker worker.c
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    TAG_TASK = 10,
+    TAG_RESULT = 11,
+    TAG_IDLE = 13
+};
+enum
+{
+    TAG_AUTH = 90,
+    TAG_AUTH_REPLY = 91,
+    TAG_ADMIT_MODE = 92,
+    TAG_JOIN_INFO = 93,
+    TAG_JOIN_TOKEN = 94,
+    TAG_JOIN_READY = 95
+};
+enum
+{
+    ADMIT_COLLECTIVE = 0,
+    ADMIT_STAR = 1, // bez merge-a: farma ide preko inter-a, master je remote rank 0
+    ADMIT_LOBBY = 2 // auth prošao u lobby-ju: reconnect na join port sa tokenom
+};
+typedef struct
+{
+    int token;
+    char port[MPI_MAX_PORT_NAME];
+} JoinInfo;
+static void perr(const char *where, int rc)
+{
+    if (rc == MPI_SUCCESS)
+        return;
+    char es[256];
+    int n = 0;
+    MPI_Error_string(rc, es, &n);
+    fprintf(stderr, "[WORKER] %s rc=%d (%s)\n", where, rc, es);
+    fflush(stderr);
+}
+
+// task-farm petlja nad C (master je rank 0: u CLUSTER-u, ili remote rank 0 u star inter-u)
+static void run_farm(MPI_Comm C)
+{
+    for (;;)
+    {
+        MPI_Status st;
+        MPI_Probe(0, MPI_ANY_TAG, C, &st);
+
+        if (st.MPI_TAG == TAG_IDLE)
+        {
+            MPI_Recv(NULL, 0, MPI_INT, 0, TAG_IDLE, C, MPI_STATUS_IGNORE);
+            continue;
+        }
+        if (st.MPI_TAG == TAG_TASK)
+        {
+            int x = 0;
+            MPI_Recv(&x, 1, MPI_INT, 0, TAG_TASK, C, MPI_STATUS_IGNORE);
+            int y = x * x;
+            int pair[2] = {x, y};
+            MPI_Send(pair, 2, MPI_INT, 0, TAG_RESULT, C);
+            continue;
+        }
+        // fallback: progutaj neočekivane tagove
+        MPI_Recv(NULL, 0, MPI_INT, 0, st.MPI_TAG, C, MPI_STATUS_IGNORE);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // (opciono) odmah viđi logove
+    setvbuf(stdout, NULL, _IONBF, 0);
+    setvbuf(stderr, NULL, _IONBF, 0);
+
+    MPI_Init(&argc, &argv);
+
+    int wr;
+    MPI_Comm_rank(MPI_COMM_WORLD, &wr);
+    if (argc < 2)
+    {
+        if (wr == 0)
+            fprintf(stderr, "usage: %s <PORT_STRING>\n", argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    char *PORT = argv[1];
+
+    // 1) Prvo spajanje: connect -> merge(high=1)
+    // (ako je PORT lobby, posle auth-a dobijamo join port i token i spajamo se ponovo)
+    MPI_Comm inter;
+    JoinInfo ji;
+    int have_token = 0;
+    int mode = ADMIT_COLLECTIVE;
+    int rc;
+    for (;;)
+    {
+        rc = MPI_Comm_connect(PORT, MPI_INFO_NULL, 0, MPI_COMM_WORLD, &inter);
+
+        perr("Comm_connect#first", rc);
+
+        // Slanje autentikacije (na join portu umesto magic-a ide token iz lobby-ja)
+        int magic =5;
+        if (have_token)
+            rc = MPI_Send(&ji.token, 1, MPI_INT, 0, TAG_JOIN_TOKEN, inter);
+        else
+            rc = MPI_Send(&magic, 1, MPI_INT, 0, TAG_AUTH, inter);
+        perr("Send(AUTH)", rc);
+        int accept_it = 0;
+        rc = MPI_Recv(&accept_it, 1, MPI_INT, 0, TAG_AUTH_REPLY, inter, MPI_STATUS_IGNORE);
+        perr("Recv(AUTH_REPLY)", rc);
+        if (!accept_it)
+        {
+
+            // Master nas je odbio — uredno zatvori i izađi.
+            rc = MPI_Comm_disconnect(&inter);
+            perr("Disconnect(rejected)", rc);
+            MPI_Finalize();
+            return 0;
+        }
+
+        rc = MPI_Recv(&mode, 1, MPI_INT, 0, TAG_ADMIT_MODE, inter, MPI_STATUS_IGNORE);
+        perr("Recv(ADMIT_MODE)", rc);
+        if (mode != ADMIT_LOBBY)
+            break;
+
+        rc = MPI_Recv(&ji, sizeof(ji), MPI_BYTE, 0, TAG_JOIN_INFO, inter, MPI_STATUS_IGNORE);
+        perr("Recv(JOIN_INFO)", rc);
+        // potvrda da odmah idemo na join port (master bez nje ne pokreće rundu)
+        rc = MPI_Send(&ji.token, 1, MPI_INT, 0, TAG_JOIN_READY, inter);
+        perr("Send(JOIN_READY)", rc);
+        MPI_Comm_disconnect(&inter);
+        ji.port[MPI_MAX_PORT_NAME - 1] = '\0';
+        PORT = ji.port;
+        have_token = 1;
+    }
+    if (mode == ADMIT_STAR)
+    {
+        printf("[WORKER %d] admitted (star)\n", wr);
+        run_farm(inter);
+        MPI_Comm_disconnect(&inter);
+        MPI_Finalize();
+        return 0;
+    }
+
+    MPI_Comm CLUSTER;
+    rc = MPI_Intercomm_merge(inter, /*high=*/1, &CLUSTER);
+    perr("Intercomm_merge#first", rc);
+    MPI_Comm_disconnect(&inter);
+
+    int rank, size;
+    MPI_Comm_rank(CLUSTER, &rank);
+    MPI_Comm_size(CLUSTER, &size);
+    printf("[WORKER %d] joined CLUSTER: size=%d\n", rank, size);
+    MPI_Barrier(CLUSTER);
+    // 2) Admission runde
+    for (;;)
+    {
+          printf("pocetak FORA");
+            fflush(stdout);
+        // poravnaj rundu sa trenutnim CLUSTER-om
+
+        // primi najavu more,len,port
+        int more = 0, len = 0;
+        char port[MPI_MAX_PORT_NAME];
+        MPI_Bcast(&more, 1, MPI_INT, 0, CLUSTER);
+        MPI_Bcast(&len, 1, MPI_INT, 0, CLUSTER);
+        if (more && len > 0 && len <= MPI_MAX_PORT_NAME)
+            MPI_Bcast(port, len, MPI_CHAR, 0, CLUSTER);
+ printf("zavrsio bcast");
+           fflush(stdout);
+        if (more)
+        {
+         //   printf("USAAOOOOO");
+           // fflush(stdout);
+        }
+        else
+        {
+            //printf("BREAAAAAAK");
+            //fflush(stdout);
+            break; // kraj admission-a
+        }
+        // svi “stari” članovi CLUSTER-a ulaze u kolektivni accept
+        MPI_Comm inter2;
+        rc = MPI_Comm_accept(port, MPI_INFO_NULL, 0, CLUSTER, &inter2);
+        perr("Comm_accept#wave", rc);
+        {
+            int accept_it = 0;
+            // SVI stari članovi CLUSTER-a moraju da pročitaju odluku koja je bcast-ovana sa mastera
+            MPI_Bcast(&accept_it, 1, MPI_INT, 0, CLUSTER);
+  printf("Prosao bcast");
+            fflush(stdout);
+            if (!accept_it)
+            {
+                // AUTH odbijen → na istom inter2 svi rade DISCONNECT, bez merge-a
+                MPI_Comm_disconnect(&inter2);
+
+                // kraj runde (poravnanje)
+                MPI_Barrier(CLUSTER);
+                continue; // idemo u sledeću rundu
+            }
+        }
+        // NEMA barijere na interu — merge je kolektivan
+        MPI_Comm CL_NEW;  printf("OVDE SAM");
+            fflush(stdout);
+        rc = MPI_Intercomm_merge(inter2, /*high (old side)*/ 0, &CL_NEW);
+        perr("Intercomm_merge#wave", rc);
+        MPI_Comm_disconnect(&inter2);
+
+        MPI_Comm_free(&CLUSTER);
+        CLUSTER = CL_NEW;
+
+        MPI_Comm_rank(CLUSTER, &rank);
+        MPI_Comm_size(CLUSTER, &size);
+        printf("[WORKER %d] post-merge CLUSTER size=%d\n", rank, size);
+        // poravnanje kraja runde
+        MPI_Barrier(CLUSTER);
+    }
+
+    // 3) Task-farm: svi osim ranga 0 rade
+    MPI_Comm_rank(CLUSTER, &rank);
+    MPI_Comm_size(CLUSTER, &size);
+
+    if (rank != 0)
+        run_farm(CLUSTER);
+
+    MPI_Comm_free(&CLUSTER);
+    MPI_Finalize();
+    return 0;
+}